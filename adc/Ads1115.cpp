@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+
+#include "utils/Logger.hpp"
+
+#include "Ads1115.hpp"
+
+namespace adc {
+
+constexpr int CONVERSION = 0x00;
+constexpr int CONFIG = 0x01;
+constexpr int LO_THRESH = 0x02;
+constexpr int HI_THRESH = 0x03;
+
+// Writing OS starts a single shot conversion.
+constexpr uint16_t OS = 0x8000;
+constexpr int MUX_SHIFT = 12;
+constexpr int PGA_SHIFT = 9;
+constexpr uint16_t SINGLE_SHOT = 0x0100;
+constexpr int DR_SHIFT = 5;
+// Disables the comparator and leaves ALERT/RDY floating.
+constexpr uint16_t COMP_DISABLE = 0x0003;
+// A high threshold with its MSB set and a low one without turns ALERT/RDY into a conversion ready signal.
+constexpr int16_t READY_HI = int16_t(0x8000);
+constexpr int16_t READY_LO = 0x0000;
+
+constexpr std::array<float, 6> RANGES = {6.144f, 4.096f, 2.048f, 1.024f, 0.512f, 0.256f};
+constexpr float FULL_SCALE = 32768.0f;
+// The internal oscillator is only good to 10%, so the schedule leaves that much for the conversion to finish.
+constexpr float OSCILLATOR_MARGIN = 1.1f;
+
+AdcInput adcInputFromString(std::string_view str) {
+    if (str == "0-1") return AdcInput::DIFF_0_1;
+    if (str == "0-3") return AdcInput::DIFF_0_3;
+    if (str == "1-3") return AdcInput::DIFF_1_3;
+    if (str == "2-3") return AdcInput::DIFF_2_3;
+    if (str == "0")   return AdcInput::AIN0;
+    if (str == "1")   return AdcInput::AIN1;
+    if (str == "2")   return AdcInput::AIN2;
+    if (str == "3")   return AdcInput::AIN3;
+    throw std::invalid_argument(std::format("adc::adcInputFromString(): Unrecognized input: {}", str));
+}
+
+static uint16_t rangeCode(float range) {
+    const auto it = std::find_if(RANGES.begin(), RANGES.end(), [range](float r) { return std::abs(r - range) < 0.001f; });
+    if (it == RANGES.end()) {
+        throw std::invalid_argument(std::format("adc::Ads1115::Ads1115(): Unsupported range: {} V", range));
+    }
+    return uint16_t(it - RANGES.begin());
+}
+
+Ads1115::Ads1115(const std::vector<AdcChannel>& channels, int rate, uint8_t address, int channel) :
+    m_device(address, true, channel),
+    m_channels(channels),
+    m_accumulators(channels.size())
+{
+    if (channels.empty() || channels.size() > MAX_CHANNELS) {
+        throw std::invalid_argument(std::format("adc::Ads1115::Ads1115(): Needs 1-{} channels, got {}", MAX_CHANNELS, channels.size()));
+    }
+    for (const auto& c : channels) {
+        rangeCode(c.range);
+        if (c.oversample == 0) {
+            throw std::invalid_argument("adc::Ads1115::Ads1115(): Oversampling must be at least 1");
+        }
+    }
+
+    const auto it = std::lower_bound(RATES.begin(), RATES.end(), rate);
+    m_rateCode = uint8_t(it == RATES.end() ? RATES.size() - 1 : it - RATES.begin());
+    m_rate = RATES[m_rateCode];
+    if (m_rate != rate) {
+        logger.info() << std::format("adc::Ads1115::Ads1115(): Converting at {} per second instead of {}", m_rate, rate);
+    }
+}
+
+Ads1115::~Ads1115() {
+    stop();
+}
+
+uint16_t Ads1115::config(size_t channel, bool ready) const {
+    const auto& c = m_channels[channel];
+    uint16_t config = (uint16_t(c.input) << MUX_SHIFT) | (rangeCode(c.range) << PGA_SHIFT) | (m_rateCode << DR_SHIFT);
+    if (m_channels.size() > 1) {
+        config |= OS | SINGLE_SHOT;
+    }
+    // The comparator asserts after every conversion, which with the ready thresholds is a falling edge on ALERT/RDY.
+    return ready ? config : config | COMP_DISABLE;
+}
+
+void Ads1115::begin(bool ready) {
+    m_current = 0;
+    m_ready = ready;
+    std::fill(m_accumulators.begin(), m_accumulators.end(), Accumulator());
+    m_device.write<int16_t>(HI_THRESH, ready ? READY_HI : int16_t(0x7FFF));
+    m_device.write<int16_t>(LO_THRESH, ready ? READY_LO : int16_t(0x8000));
+    m_device.write<int16_t>(CONFIG, int16_t(config(m_current, ready)));
+}
+
+void Ads1115::start() {
+    stop();
+    begin(false);
+    // The first job runs as soon as it is scheduled, before the first conversion is done.
+    m_skip = true;
+
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(OSCILLATOR_MARGIN / float(m_rate)));
+    m_job = m_device.bus().schedule(period, m_device.mux(), m_device.channel(), [this] { convert(Clock::now()); });
+}
+
+void Ads1115::startReady(int pin) {
+    stop();
+
+    m_readyPin = std::make_unique<wiring::InputPin>(wiring::PinConfig{pin, wiring::PinMode::IN});
+    m_readyPin->setAlert([this](int, bool level, Clock::time_point time) {
+        if (!level) {
+            convert(time);
+        }
+    });
+    begin(true);
+}
+
+void Ads1115::stop() {
+    if (m_job) {
+        m_device.bus().unschedule(*m_job);
+        m_job.reset();
+    }
+    if (m_readyPin) {
+        m_readyPin.reset();
+    }
+    // Back to the power down state it starts in.
+    m_device.write<int16_t>(CONFIG, int16_t(SINGLE_SHOT | COMP_DISABLE));
+}
+
+void Ads1115::convert(Clock::time_point time) {
+    if (m_skip) {
+        m_skip = false;
+        return;
+    }
+    const auto raw = m_device.read<int16_t>(CONVERSION);
+    const auto channel = m_current;
+
+    // Start the next channel straight away so it converts while this one is averaged.
+    if (m_channels.size() > 1) {
+        m_current = (m_current + 1) % m_channels.size();
+        m_device.write<int16_t>(CONFIG, int16_t(config(m_current, m_ready)));
+    }
+
+    auto& acc = m_accumulators[channel];
+    acc.sum += raw;
+    acc.count++;
+    if (acc.count < m_channels[channel].oversample) {
+        return;
+    }
+
+    const auto volts = float(acc.sum) / float(acc.count) * m_channels[channel].range / FULL_SCALE;
+    acc = Accumulator();
+    if (!m_queue.push({time, channel, volts})) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace adc
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "utils/Clock.hpp"
+#include "utils/SpscQueue.hpp"
+#include "wiring/I2cBus.hpp"
+#include "wiring/I2cDevice.hpp"
+#include "wiring/Pin.hpp"
+
+namespace adc {
+
+// What an ADS1115 channel converts, as set in the MUX bits of the config register.
+enum class AdcInput : uint8_t {
+    DIFF_0_1,
+    DIFF_0_3,
+    DIFF_1_3,
+    DIFF_2_3,
+    AIN0,
+    AIN1,
+    AIN2,
+    AIN3,
+};
+
+// "0" to "3" for the single ended inputs and "0-1", "0-3", "1-3" or "2-3" for the differential pairs.
+AdcInput adcInputFromString(std::string_view str);
+
+struct AdcChannel {
+    AdcInput input = AdcInput::AIN0;
+    // The full scale range in volts, one of 6.144, 4.096, 2.048, 1.024, 0.512 or 0.256.
+    float range = 4.096f;
+    // The conversions averaged into each reading, which cuts the noise and the rate by as much.
+    size_t oversample = 1;
+};
+
+struct Reading {
+    Clock::time_point time;
+    size_t channel;
+    float volts;
+};
+
+// A TI ADS1115 16 bit ADC on the I2C bus, converting one or more channels in the background.
+// A single channel runs in continuous mode and is only ever read, while several are converted in turn,
+// starting each single shot conversion as the last one is read.
+// Conversions are read when the ALERT/RDY pin signals they are done, or otherwise by a job on the bus scheduler
+// that runs just slower than the conversion rate, so nothing ever waits on a conversion.
+// Readings are queued for the consumer, which pops them without touching the bus.
+class Ads1115 {
+public:
+    static constexpr uint8_t ADDRESS = 0x48;
+    // The data rates in conversions per second.
+    static constexpr std::array<int, 8> RATES = {8, 16, 32, 64, 128, 250, 475, 860};
+    static constexpr size_t MAX_CHANNELS = 8;
+
+    // rate is rounded up to the next data rate of the chip.
+    Ads1115(const std::vector<AdcChannel>& channels, int rate, uint8_t address = ADDRESS, int channel = wiring::I2cBus::NO_CHANNEL);
+    ~Ads1115();
+
+    Ads1115(const Ads1115&) = delete;
+    Ads1115& operator=(const Ads1115&) = delete;
+
+    // The conversions per second, shared by every channel.
+    int rate() const { return m_rate; }
+    size_t channels() const { return m_channels.size(); }
+
+    // Reads the conversions on a schedule.
+    void start();
+    // Reads each conversion on the falling edge of the ALERT/RDY pin, which must be wired to pin.
+    void startReady(int pin);
+    void stop();
+
+    // Pops the oldest reading. Returns false if there are none.
+    bool pop(Reading& reading) { return m_queue.pop(reading); }
+
+    // Readings lost to a full queue.
+    size_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Accumulator {
+        int64_t sum = 0;
+        size_t count = 0;
+    };
+
+    uint16_t config(size_t channel, bool ready) const;
+    // Starts the conversions, with the ALERT/RDY pin signalling them if ready.
+    void begin(bool ready);
+
+    // Reads the finished conversion and starts the next one.
+    void convert(Clock::time_point time);
+
+    const wiring::I2cDevice m_device;
+    const std::vector<AdcChannel> m_channels;
+    int m_rate;
+    uint8_t m_rateCode;
+
+    // Only touched by whichever of the scheduler and the alert thread is converting.
+    std::vector<Accumulator> m_accumulators;
+    size_t m_current = 0;
+    bool m_ready = false;
+    bool m_skip = false;
+
+    std::optional<wiring::I2cBus::JobId> m_job;
+    std::unique_ptr<wiring::InputPin> m_readyPin;
+    SpscQueue<Reading, 256> m_queue;
+    std::atomic<size_t> m_dropped = 0;
+};
+
+} // namespace adc
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+#include "utils/Logger.hpp"
+
+#include "Sensor.hpp"
+
+namespace adc {
+
+// Each channel exports its scaled value then its volts.
+constexpr size_t VALUES_PER_CHANNEL = 2;
+constexpr size_t SCALED = 0;
+constexpr size_t VOLTS = 1;
+
+static std::vector<AdcChannel> adcChannels(const std::vector<SensorChannel>& channels) {
+    std::vector<AdcChannel> adc;
+    for (const auto& c : channels) {
+        adc.push_back(c.adc);
+    }
+    return adc;
+}
+
+Sensor::Sensor(const SensorConfig& config, bool live) :
+    pi::Input("Adc", VALUES_PER_CHANNEL * config.channels.size()),
+    m_channels(config.channels),
+    m_adc(live ? std::make_unique<Ads1115>(adcChannels(config.channels), config.rate, config.address, config.channel) : nullptr)
+{
+    for (size_t i = 0; i < m_channels.size(); i++) {
+        if (m_channels[i].name.empty() || m_channels[i].name.find('.') != std::string::npos) {
+            throw std::invalid_argument(std::format("adc::Sensor::Sensor(): Channel names must be non-empty without dots: \"{}\"", m_channels[i].name));
+        }
+        if (std::find_if(m_channels.begin(), m_channels.begin() + i, [&](const SensorChannel& c) { return c.name == m_channels[i].name; }) != m_channels.begin() + i) {
+            throw std::invalid_argument(std::format("adc::Sensor::Sensor(): Duplicate channel name: {}", m_channels[i].name));
+        }
+    }
+
+    if (m_adc != nullptr) {
+        if (config.readyPin >= 0) {
+            m_adc->startReady(config.readyPin);
+        }
+        else {
+            m_adc->start();
+        }
+    }
+}
+
+void Sensor::poll() {
+    if (m_adc == nullptr) {
+        return;
+    }
+
+    Reading reading;
+    while (m_adc->pop(reading)) {
+        record(reading);
+        update(reading);
+    }
+
+    const auto dropped = m_adc->dropped();
+    if (dropped != m_dropped) {
+        logger.warning() << std::format("adc::Sensor::poll(): Dropped {} readings", dropped - m_dropped);
+        m_dropped = dropped;
+    }
+}
+
+void Sensor::replay(std::span<const std::byte> event) {
+    if (event.size() != sizeof(Reading)) {
+        throw std::invalid_argument(std::format("adc::Sensor::replay(): Events must be {} bytes", sizeof(Reading)));
+    }
+    Reading reading;
+    std::memcpy(&reading, event.data(), sizeof(Reading));
+    if (reading.channel >= m_channels.size()) {
+        throw std::invalid_argument(std::format("adc::Sensor::replay(): No channel {}", reading.channel));
+    }
+    update(reading);
+}
+
+void Sensor::update(const Reading& reading) {
+    const auto& channel = m_channels[reading.channel];
+    m_values[VALUES_PER_CHANNEL * reading.channel + SCALED] = reading.volts * channel.scale + channel.offset;
+    m_values[VALUES_PER_CHANNEL * reading.channel + VOLTS] = reading.volts;
+}
+
+size_t Sensor::index(std::string_view key) const {
+    const auto dot = key.find('.');
+    const auto name = key.substr(0, dot);
+    const auto suffix = dot == std::string_view::npos ? std::string_view() : key.substr(dot + 1);
+    for (size_t i = 0; i < m_channels.size(); i++) {
+        if (m_channels[i].name != name) {
+            continue;
+        }
+        if (suffix.empty())    return VALUES_PER_CHANNEL * i + SCALED;
+        if (suffix == "volts") return VALUES_PER_CHANNEL * i + VOLTS;
+    }
+    throw std::invalid_argument(std::format("adc::Sensor::index(): Unrecognized key: {}", key));
+}
+
+} // namespace adc
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pi/Input.hpp"
+
+#include "Ads1115.hpp"
+
+namespace adc {
+
+struct SensorChannel {
+    std::string name;
+    AdcChannel adc;
+    // The exported value is volts * scale + offset, such as the ratio of a divider in front of a battery
+    // or the amps per volt of a current sense amplifier.
+    float scale = 1.0f;
+    float offset = 0.0f;
+};
+
+struct SensorConfig {
+    uint8_t address = Ads1115::ADDRESS;
+    // The TCA9548A channel the ADC is behind, if any.
+    int channel = wiring::I2cBus::NO_CHANNEL;
+    // Conversions per second, shared by the channels in turn.
+    int rate = 128;
+    // Reads on the schedule when negative.
+    int readyPin = -1;
+    std::vector<SensorChannel> channels;
+};
+
+// Exports each channel by its name, scaled, and as "<name>.volts" at the pin.
+// Every reading is recorded as it is polled.
+class Sensor : public pi::Input {
+public:
+    Sensor(const SensorConfig& config, bool live = true);
+
+    void poll() override;
+
+    size_t index(std::string_view key) const override;
+
+    // Replays one Reading.
+    void replay(std::span<const std::byte> event) override;
+
+private:
+    void update(const Reading& reading);
+
+    const std::vector<SensorChannel> m_channels;
+    // Null when not live.
+    std::unique_ptr<Ads1115> m_adc;
+    size_t m_dropped = 0;
+};
+
+} // namespace adc
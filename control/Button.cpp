@@ -1,15 +1,90 @@
+#include "utils/Logger.hpp"
+
 #include "Button.hpp"
 
 namespace control {
 
-Button::Button(int pin, bool toggle) :
-    pi::Input("Button"),
-    m_pin(wiring::Pin::create({pin, wiring::PinMode::IN, true})),
-    m_toggle(toggle)
-{}
+enum ButtonValue : size_t {
+    VALUE,
+    PRESSES,
+    LAST_EDGE,
+    STATE,
+    NUM_VALUES
+};
+
+Button::Button(int pin, bool toggle, bool live) :
+    pi::Input("Button", NUM_VALUES),
+    m_pin(live ? std::make_unique<wiring::InputPin>(wiring::PinConfig{pin, wiring::PinMode::IN, true}) : nullptr),
+    m_toggle(toggle),
+    m_edge(false),
+    m_lastEdge(Clock::now())
+{
+    publish();
+}
+
+Button::Button(int pin, bool toggle, Clock::duration glitch, bool live) :
+    pi::Input("Button", NUM_VALUES),
+    m_pin(live ? std::make_unique<wiring::InputPin>(wiring::PinConfig{pin, wiring::PinMode::IN, true}) : nullptr),
+    m_toggle(toggle),
+    m_edge(true),
+    m_lastEdge(Clock::now())
+{
+    if (m_pin != nullptr) {
+        m_last = m_pin->get() == 1.0f;
+        m_pin->setAlert([this](int, bool pressed, Clock::time_point time) {
+            if (!m_edges.push({time, pressed})) {
+                m_overflow = true;
+            }
+        }, glitch);
+    }
+    publish();
+}
+
+Button::~Button() {
+    // The alert pushes into m_edges, which is gone before m_pin would unregister it.
+    if (m_edge && m_pin != nullptr) {
+        m_pin->setAlert(nullptr);
+    }
+}
 
 void Button::poll() {
-    const auto pressed = m_pin->get() == 1.0f;
+    if (m_pin == nullptr) {
+        return;
+    }
+
+    if (m_edge) {
+        Edge edge;
+        while (m_edges.pop(edge)) {
+            record(uint8_t(edge.pressed));
+            update(edge.pressed, edge.time);
+        }
+        if (m_overflow.exchange(false)) {
+            logger.warning() << "control::Button::poll(): Dropped edges";
+        }
+    }
+    else {
+        const auto pressed = m_pin->get() == 1.0f;
+        if (pressed != m_last) {
+            record(uint8_t(pressed));
+        }
+        update(pressed, Clock::now());
+    }
+    publish();
+}
+
+void Button::replay(std::span<const std::byte> event) {
+    if (event.size() != 1) {
+        throw std::invalid_argument("control::Button::replay(): Events must be 1 byte");
+    }
+    update(event[0] != std::byte{0}, Clock::now());
+    publish();
+}
+
+void Button::update(bool pressed, Clock::time_point time) {
+    if (pressed != m_last) {
+        m_lastEdge = time;
+        m_presses += pressed;
+    }
 
     // Rising edge.
     if (pressed && !m_last && (!m_toggle || !m_value)) {
@@ -23,11 +98,19 @@ void Button::poll() {
     m_last = pressed;
 }
 
-pi::Producer Button::getProducer(std::string_view key) const {
-    if (key != "value") {
-        throw std::invalid_argument("control::Button::read(): only accepts \"value\"");
-    }
-    return [this]() { return m_value ? 1.0f : 0.0f; };
+void Button::publish() {
+    m_values[VALUE] = m_value ? 1.0f : 0.0f;
+    m_values[PRESSES] = float(m_presses);
+    m_values[LAST_EDGE] = std::chrono::duration<float>(Clock::now() - m_lastEdge).count();
+    m_values[STATE] = m_last ? 1.0f : 0.0f;
+}
+
+size_t Button::index(std::string_view key) const {
+    if (key == "value")     return VALUE;
+    if (key == "presses")   return PRESSES;
+    if (key == "last-edge") return LAST_EDGE;
+    if (key == "state")     return STATE;
+    throw std::invalid_argument(std::format("control::Button::index(): Unrecognized key: {}", key));
 }
 
 } // namespace control
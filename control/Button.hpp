@@ -2,26 +2,54 @@
 
 #include <memory>
 
+#include "utils/Clock.hpp"
+#include "utils/SpscQueue.hpp"
 #include "wiring/Pin.hpp"
 
 #include "pi/Input.hpp"
 
 namespace control {
 
+// Exports "value", which follows the button or flips on each press when toggling,
+// "presses", the number of presses so far, "last-edge", the seconds since the button last changed,
+// and "state", whether the button is held.
+// Polled buttons sample the pin once per poll. Edge buttons queue every edge from the backend as it happens,
+// so short taps are never missed, and filter out glitches shorter than the given duration.
 class Button : public pi::Input {
 public:
-    Button(int pin, bool toggle);
-    virtual ~Button() override {}
+    Button(int pin, bool toggle, bool live = true);
+    Button(int pin, bool toggle, Clock::duration glitch, bool live = true);
+    virtual ~Button() override;
 
-    void poll();
+    void poll() override;
 
-    pi::Producer getProducer(std::string_view key) const override;
+    size_t index(std::string_view key) const override;
+
+    // Replays an edge, recorded as a single pressed byte.
+    void replay(std::span<const std::byte> event) override;
 
 private:
-    std::unique_ptr<wiring::Pin> m_pin;
+    struct Edge {
+        Clock::time_point time;
+        bool pressed;
+    };
+
+    static constexpr size_t QUEUE_SIZE = 256;
+
+    void update(bool pressed, Clock::time_point time);
+    void publish();
+
+    // Null when not live.
+    std::unique_ptr<wiring::InputPin> m_pin;
     const bool m_toggle;
+    const bool m_edge;
     bool m_last = false;
     bool m_value = false;
+    uint32_t m_presses = 0;
+    Clock::time_point m_lastEdge;
+    // Filled by the backend thread in edge mode.
+    SpscQueue<Edge, QUEUE_SIZE> m_edges;
+    std::atomic_bool m_overflow = false;
 };
 
 } // namespace control
@@ -1,3 +1,4 @@
+#include <array>
 #include <cstdint>
 #include <format>
 #include <limits>
@@ -15,10 +16,28 @@
 
 namespace device {
 
-Controller::Controller(std::string_view id) : 
-    pi::Input(id),
-    m_socket(open(std::format("/dev/input/{}", id).c_str(), O_RDONLY))
-{}
+CREATE_ENUM_SET(ControllerBind, X, CIRCLE, TRIANGLE, SQUARE, LB, RB, SHARE, OPTIONS, PS, LSTICK, RSTICK, LT, RT, LJOY, RJOY, DPAD)
+CREATE_ENUM_SET(ControllerJoy, X, Y, LEFT, UP, RIGHT, DOWN)
+
+constexpr size_t NUM_JOY_VALUES = 6;
+
+// The exported values. The buttons and triggers follow the ControllerBind order
+// and each joystick is followed by its values in the ControllerJoy order.
+enum ControllerValue : size_t {
+    LT_VALUE = to_underlying(ControllerBind::LT),
+    RT_VALUE = to_underlying(ControllerBind::RT),
+    LJOY_VALUE,
+    RJOY_VALUE = LJOY_VALUE + NUM_JOY_VALUES,
+    DPAD_VALUE = RJOY_VALUE + NUM_JOY_VALUES,
+    NUM_VALUES = DPAD_VALUE + NUM_JOY_VALUES
+};
+
+Controller::Controller(std::string_view id, bool live) :
+    pi::Input(id, NUM_VALUES),
+    m_socket(live ? std::make_unique<const Socket>(open(std::format("/dev/input/{}", id).c_str(), O_RDONLY)) : nullptr)
+{
+    update();
+}
 
 enum ControllerEventType : uint8_t {
     BUTTON = 1,
@@ -77,178 +96,189 @@ private:
     uint8_t m_id = 0;
 };
 static_assert(std::is_trivially_copyable_v<ControllerEvent>);
+static_assert(Controller::BUFFER_SIZE % sizeof(ControllerEvent) == 0);
 
 void Controller::poll() {
-    const auto buffer = m_socket.read();
+    if (m_socket == nullptr) {
+        return;
+    }
+
+    bool changed = false;
+    size_t size = 0;
+    do {
+        size = m_socket->read(m_buffer);
+        if (size % sizeof(ControllerEvent) != 0) {
+            throw std::logic_error("Assumed controller events are 8 bytes");
+        }
+        if (size == 0) {
+            break;
+        }
+
+        record(std::as_bytes(std::span(m_buffer.data(), size)));
+        handle(std::span(reinterpret_cast<const ControllerEvent*>(m_buffer.data()), size / sizeof(ControllerEvent)));
+        changed = true;
+    } while (size == m_buffer.size());
 
-    if (buffer.size() % sizeof(ControllerEvent) != 0) {
-        throw std::logic_error("Assumed controller events are 8 bytes");
+    if (changed) {
+        update();
     }
-    const std::span<const ControllerEvent> events(
-        reinterpret_cast<const ControllerEvent*>(buffer.data()),
-        buffer.size() / sizeof(ControllerEvent));
-    
+}
+
+void Controller::replay(std::span<const std::byte> event) {
+    if (event.size() % sizeof(ControllerEvent) != 0) {
+        throw std::invalid_argument("device::Controller::replay(): Events must be 8 bytes");
+    }
+    // The payload is 8 byte aligned in the log.
+    handle(std::span(reinterpret_cast<const ControllerEvent*>(event.data()), event.size() / sizeof(ControllerEvent)));
+    update();
+}
+
+void Controller::handle(std::span<const ControllerEvent> events) {
     for (const auto& event : events) {
-        switch (event.type()) {
-        case BUTTON:
+        handle(event);
+    }
+}
+
+void Controller::handle(const ControllerEvent& event) {
+    switch (event.type()) {
+    case BUTTON:
+    {
+        ButtonState* button = nullptr;
+        switch (event.id()) {
+        case X:            button = &m_state.xButton; break;
+        case CIRCLE:       button = &m_state.circleButton; break;
+        case TRIANGLE:     button = &m_state.triangleButton; break;
+        case SQUARE:       button = &m_state.squareButton; break;
+        case LEFT_BUMPER:  button = &m_state.leftBumper; break;
+        case RIGHT_BUMPER: button = &m_state.rightBumper; break;
+        case LEFT_TRIGGER_BUTTON:
+        case RIGHT_TRIGGER_BUTTON: break;
+        case SHARE:        button = &m_state.shareButton; break;
+        case OPTIONS:      button = &m_state.optionsButton; break;
+        case PS:           button = &m_state.playstationButton; break;
+        case LEFT_STICK:   button = &m_state.leftStick; break;
+        case RIGHT_STICK:  button = &m_state.rightStick; break;
+        default: throw std::logic_error(std::format("Unknown controller button id: {}", event.id()));
+        }
+        
+        if (button != nullptr) {
+            bool pressed;
+            switch (event.data()) {
+            case PRESSED:  pressed = true; break;
+            case RELEASED: pressed = false; break;
+            default: throw std::logic_error(std::format("Unknown controller data"));
+            }
+            button->pressed = pressed;
+        }
+        break;
+    }
+    case AXIS:
+    {
+        const auto data = Axis(event.data());
+        switch (event.id()) {
+        case X_LEFT_JOY:    m_state.xLeftJoy = data; break;
+        case Y_LEFT_JOY:    m_state.yLeftJoy = -data; break;
+        case LEFT_TRIGGER:  m_state.leftTrigger = uAxis(data + std::numeric_limits<int16_t>::max()); break;
+        case X_RIGHT_JOY:   m_state.xRightJoy = data; break;
+        case Y_RIGHT_JOY:   m_state.yRightJoy = -data; break;
+        case RIGHT_TRIGGER: m_state.rightTrigger = uAxis(data + std::numeric_limits<int16_t>::max()); break;
+        case X_DPAD:
         {
-            ButtonState* button = nullptr;
-            switch (event.id()) {
-            case X:            button = &m_state.xButton; break;
-            case CIRCLE:       button = &m_state.circleButton; break;
-            case TRIANGLE:     button = &m_state.triangleButton; break;
-            case SQUARE:       button = &m_state.squareButton; break;
-            case LEFT_BUMPER:  button = &m_state.leftBumper; break;
-            case RIGHT_BUMPER: button = &m_state.rightBumper; break;
-            case LEFT_TRIGGER_BUTTON:
-            case RIGHT_TRIGGER_BUTTON: break;
-            case SHARE:        button = &m_state.shareButton; break;
-            case OPTIONS:      button = &m_state.optionsButton; break;
-            case PS:           button = &m_state.playstationButton; break;
-            case LEFT_STICK:   button = &m_state.leftStick; break;
-            case RIGHT_STICK:  button = &m_state.rightStick; break;
-            default: throw std::logic_error(std::format("Unknown controller button id: {}", event.id()));
+            const auto sData = int16_t(data);
+            uint8_t dir = NONE;
+            if (sData < 0) {
+                dir |= LEFT;
             }
-            
-            if (button != nullptr) {
-                bool pressed;
-                switch (event.data()) {
-                case PRESSED:  pressed = true; break;
-                case RELEASED: pressed = false; break;
-                default: throw std::logic_error(std::format("Unknown controller data"));
-                }
-                button->pressed = pressed;
+            else if (sData > 0) {
+                dir |= RIGHT;
             }
+
+            m_state.directionalPad = Direction(dir | (m_state.directionalPad & (UP | DOWN)));
             break;
         }
-        case AXIS:
+        case Y_DPAD:
         {
-            const auto data = Axis(event.data());
-            switch (event.id()) {
-            case X_LEFT_JOY:    m_state.xLeftJoy = data; break;
-            case Y_LEFT_JOY:    m_state.yLeftJoy = -data; break;
-            case LEFT_TRIGGER:  m_state.leftTrigger = uAxis(data + std::numeric_limits<int16_t>::max()); break;
-            case X_RIGHT_JOY:   m_state.xRightJoy = data; break;
-            case Y_RIGHT_JOY:   m_state.yRightJoy = -data; break;
-            case RIGHT_TRIGGER: m_state.rightTrigger = uAxis(data + std::numeric_limits<int16_t>::max()); break;
-            case X_DPAD:
-            {
-                const auto sData = int16_t(data);
-                uint8_t dir = NONE;
-                if (sData < 0) {
-                    dir |= LEFT;
-                }
-                else if (sData > 0) {
-                    dir |= RIGHT;
-                }
-
-                m_state.directionalPad = Direction(dir | (m_state.directionalPad & (UP | DOWN)));
-                break;
-            }
-            case Y_DPAD:
-            {
-                const auto sData = int16_t(data);
-                uint8_t dir = NONE;
-                if (sData < 0) {
-                    dir |= UP;
-                }
-                else if (sData > 0) {
-                    dir |= DOWN;
-                }
-
-                m_state.directionalPad = Direction(dir | (m_state.directionalPad & (LEFT | RIGHT)));
-                break;
+            const auto sData = int16_t(data);
+            uint8_t dir = NONE;
+            if (sData < 0) {
+                dir |= UP;
             }
-            default: throw std::logic_error(std::format("Unknown controller axis id: {}", event.id()));
+            else if (sData > 0) {
+                dir |= DOWN;
             }
+
+            m_state.directionalPad = Direction(dir | (m_state.directionalPad & (LEFT | RIGHT)));
             break;
         }
-        default: throw std::logic_error(std::format("Unknown controller event type: {}", event.type()));
+        default: throw std::logic_error(std::format("Unknown controller axis id: {}", event.id()));
         }
+        break;
+    }
+    default: throw std::logic_error(std::format("Unknown controller event type: {}", event.type()));
     }
 }
 
-CREATE_ENUM_SET(ControllerBind, X, CIRCLE, TRIANGLE, SQUARE, LB, RB, SHARE, OPTIONS, PS, LSTICK, RSTICK, LT, RT, LJOY, RJOY, DPAD)
-CREATE_ENUM_SET(ControllerJoy, X, Y, LEFT, UP, RIGHT, DOWN)
-
-pi::Producer Controller::getProducer(std::string_view key) const {
+size_t Controller::index(std::string_view key) const {
     const auto period = key.find('.');
     auto bindStr = key.substr(0, period);
     const auto bind = ControllerBindFromString(bindStr);
 
-    const ButtonState* button = nullptr;
-    switch (bind) {
-    case ControllerBind::X:        button = &m_state.xButton; break;
-    case ControllerBind::CIRCLE:   button = &m_state.circleButton; break;
-    case ControllerBind::TRIANGLE: button = &m_state.triangleButton; break;
-    case ControllerBind::SQUARE:   button = &m_state.squareButton; break;
-    case ControllerBind::LB:       button = &m_state.leftBumper; break;
-    case ControllerBind::RB:       button = &m_state.rightBumper; break;
-    case ControllerBind::SHARE:    button = &m_state.shareButton; break;
-    case ControllerBind::OPTIONS:  button = &m_state.optionsButton; break;
-    case ControllerBind::PS:       button = &m_state.playstationButton; break;
-    case ControllerBind::LSTICK:   button = &m_state.leftStick; break;
-    case ControllerBind::RSTICK:   button = &m_state.rightStick; break;
-    default: break;
-    }
-
-    // Handle all the buttons.
-    if (button != nullptr) {
-        return [button]() { return button->pressed ? 1.0f : 0.0f; };
-    }
-
-    const uAxis* axis = nullptr;
-    switch (bind) {
-    case ControllerBind::LT: axis = &m_state.leftTrigger; break;
-    case ControllerBind::RT: axis = &m_state.rightTrigger; break;
-    default: break;
-    }
-
-    // Handle the individual triggers.
-    if (axis != nullptr) {
-        return [axis]() { return normalize(*axis); };
+    // Handle all the buttons and the individual triggers.
+    if (bind <= ControllerBind::RT) {
+        return to_underlying(bind);
     }
 
     if (period == std::string_view::npos) {
         throw std::invalid_argument("All axis binds must contain at least one period");
     }
     const auto valueStr = tolower(key.substr(period + 1));
-    const auto value = ControllerJoyFromString(valueStr);
+    const auto value = to_underlying(ControllerJoyFromString(valueStr));
 
-    const Axis* axes = nullptr;
     switch (bind) {
-    case ControllerBind::LJOY: axes = &m_state.xLeftJoy; break;
-    case ControllerBind::RJOY: axes = &m_state.xRightJoy; break;
-    default: break;
+    case ControllerBind::LJOY: return LJOY_VALUE + value;
+    case ControllerBind::RJOY: return RJOY_VALUE + value;
+    case ControllerBind::DPAD: return DPAD_VALUE + value;
+    default: throw std::invalid_argument(std::format("Unrecognized controller bind: {}", key));
     }
+}
 
-    // Handle all the joysticks.
-    if (axes != nullptr) {
-        switch (value) {
-        case ControllerJoy::X:     return [axes]() { return normalize(axes[0]); };
-        case ControllerJoy::Y:     return [axes]() { return normalize(axes[1]); };
-        case ControllerJoy::LEFT:  return [axes]() { return normalize(axes[0] < 0 ? -axes[0] : Axis(0)); };
-        case ControllerJoy::UP:    return [axes]() { return normalize(axes[1] > 0 ?  axes[1] : Axis(0)); };
-        case ControllerJoy::RIGHT: return [axes]() { return normalize(axes[0] > 0 ?  axes[0] : Axis(0)); };
-        case ControllerJoy::DOWN:  return [axes]() { return normalize(axes[1] < 0 ? -axes[1] : Axis(0)); };
-        default: throw std::invalid_argument(std::format("Unrecognized controller joystick bind: {}", valueStr));
-        }
-    }
-    // Handle the directional pad.
-    else if (bind == ControllerBind::DPAD) {        
-        switch (value) {
-        case ControllerJoy::X:     return [this]() { return float(int((m_state.directionalPad & RIGHT) > 0) - int((m_state.directionalPad & LEFT) > 0)); };
-        case ControllerJoy::Y:     return [this]() { return float(int((m_state.directionalPad & UP   ) > 0) - int((m_state.directionalPad & DOWN) > 0)); };
-        case ControllerJoy::LEFT:  return [this]() { return float((m_state.directionalPad & LEFT ) > 0); };
-        case ControllerJoy::UP:    return [this]() { return float((m_state.directionalPad & UP   ) > 0); };
-        case ControllerJoy::RIGHT: return [this]() { return float((m_state.directionalPad & RIGHT) > 0); };
-        case ControllerJoy::DOWN:  return [this]() { return float((m_state.directionalPad & DOWN ) > 0); };
-        default: throw std::invalid_argument(std::format("Unrecognized controller directional pad bind: {}", valueStr));
-        }
-    }
-    else {
-        throw std::invalid_argument(std::format("Unrecognized controller bind: {}", key));
+void writeJoy(float* out, float x, float y) {
+    out[to_underlying(ControllerJoy::X)]     = x;
+    out[to_underlying(ControllerJoy::Y)]     = y;
+    out[to_underlying(ControllerJoy::LEFT)]  = x < 0.0f ? -x : 0.0f;
+    out[to_underlying(ControllerJoy::UP)]    = y > 0.0f ?  y : 0.0f;
+    out[to_underlying(ControllerJoy::RIGHT)] = x > 0.0f ?  x : 0.0f;
+    out[to_underlying(ControllerJoy::DOWN)]  = y < 0.0f ? -y : 0.0f;
+}
+
+void Controller::update() {
+    const std::array<const ButtonState*, to_underlying(ControllerBind::LT)> buttons = {
+        &m_state.xButton,
+        &m_state.circleButton,
+        &m_state.triangleButton,
+        &m_state.squareButton,
+        &m_state.leftBumper,
+        &m_state.rightBumper,
+        &m_state.shareButton,
+        &m_state.optionsButton,
+        &m_state.playstationButton,
+        &m_state.leftStick,
+        &m_state.rightStick
+    };
+    for (size_t i = 0; i < buttons.size(); i++) {
+        m_values[i] = buttons[i]->pressed ? 1.0f : 0.0f;
     }
+
+    m_values[LT_VALUE] = normalize(m_state.leftTrigger);
+    m_values[RT_VALUE] = normalize(m_state.rightTrigger);
+
+    writeJoy(&m_values[LJOY_VALUE], normalize(m_state.xLeftJoy), normalize(m_state.yLeftJoy));
+    writeJoy(&m_values[RJOY_VALUE], normalize(m_state.xRightJoy), normalize(m_state.yRightJoy));
+
+    const auto dpad = m_state.directionalPad;
+    writeJoy(&m_values[DPAD_VALUE],
+        float(int((dpad & RIGHT) > 0) - int((dpad & LEFT) > 0)),
+        float(int((dpad & UP   ) > 0) - int((dpad & DOWN) > 0)));
 }
 
 } // namespace device
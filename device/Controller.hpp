@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <memory>
+
 #include "utils/Socket.hpp"
 
 #include "ControllerState.hpp"
@@ -7,18 +10,33 @@
 
 namespace device {
 
+struct ControllerEvent;
+
 class Controller : public pi::Input {
 public:
-    explicit Controller(std::string_view id);
+    explicit Controller(std::string_view id, bool live = true);
     virtual ~Controller() override {}
 
     void poll() override;
 
-    pi::Producer getProducer(std::string_view key) const override;
+    size_t index(std::string_view key) const override;
+
+    // Replays a batch of raw controller events.
+    void replay(std::span<const std::byte> event) override;
+
+    static constexpr size_t BUFFER_SIZE = 512;
 
 private:
-    const Socket m_socket;
+    void handle(std::span<const ControllerEvent> events);
+    void handle(const ControllerEvent& event);
+
+    // Writes the exported values from the state.
+    void update();
+
+    // Null when not live.
+    const std::unique_ptr<const Socket> m_socket;
     ControllerState m_state;
+    alignas(8) std::array<char, BUFFER_SIZE> m_buffer;
 };
 
 } // namespace device
@@ -44,7 +44,7 @@ public:
     ButtonState leftStick;
     ButtonState rightStick;
 
-    Direction directionalPad;
+    Direction directionalPad = NONE;
  
     uAxis leftTrigger = 0;
     uAxis rightTrigger = 0;
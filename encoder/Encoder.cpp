@@ -0,0 +1,82 @@
+#include <thread>
+
+#include "Encoder.hpp"
+
+namespace encoder {
+
+// The count change from the old state to the new, indexed by old * 4 + new.
+// A leads B going forward, so the states go 00, 01, 11, 10. Only one pin changes per edge, so the diagonal never occurs.
+constexpr std::array<int8_t, 16> TRANSITIONS = {
+     0,  1, -1,  0,
+    -1,  0,  0,  1,
+     1,  0,  0, -1,
+     0, -1,  1,  0,
+};
+constexpr uint64_t CYCLE = 4;
+constexpr uint64_t LEVELS = 3;
+constexpr int EDGE_SHIFT = 2;
+
+Encoder::Encoder(int pinA, int pinB, Clock::duration glitch) :
+    m_pinA(wiring::PinConfig{pinA, wiring::PinMode::IN}),
+    m_pinB(wiring::PinConfig{pinB, wiring::PinMode::IN})
+{
+    m_state.store(uint64_t((m_pinA.get() != 0.0f ? 1 : 0) | (m_pinB.get() != 0.0f ? 2 : 0)), std::memory_order_relaxed);
+    m_pinA.setAlert([this](int, bool level, Clock::time_point time) { edge(0, level, time); }, glitch);
+    m_pinB.setAlert([this](int, bool level, Clock::time_point time) { edge(1, level, time); }, glitch);
+}
+
+Encoder::~Encoder() {
+    m_pinA.setAlert(nullptr);
+    m_pinB.setAlert(nullptr);
+}
+
+void Encoder::edge(int channel, bool level, Clock::time_point time) {
+    // The pins may alert from different threads, so the state is swapped in rather than stored,
+    // and the edge count swapped in with it gives each edge its place.
+    const uint64_t bit = 1 << channel;
+    auto state = m_state.load(std::memory_order_relaxed);
+    uint64_t next;
+    int delta;
+    do {
+        const auto levels = level ? (state | bit) & LEVELS : state & LEVELS & ~bit;
+        delta = TRANSITIONS[(state & LEVELS) * 4 + levels];
+        next = (((state >> EDGE_SHIFT) + (delta != 0 ? 1 : 0)) << EDGE_SHIFT) | levels;
+    } while (!m_state.compare_exchange_weak(state, next, std::memory_order_relaxed));
+
+    if (delta == 0) {
+        m_errors.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // A snapshot that sees any of the writes below also sees the edge in m_state, and retries.
+    std::atomic_thread_fence(std::memory_order_release);
+    const auto edge = state >> EDGE_SHIFT;
+    // Only when the other pin's alert thread is part way through the edge before.
+    while (m_edges.load(std::memory_order_acquire) != edge) {
+        std::this_thread::yield();
+    }
+    m_times[edge % HISTORY].store(time.time_since_epoch().count(), std::memory_order_relaxed);
+    m_direction.store(delta, std::memory_order_relaxed);
+    m_count.store(m_count.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    // Published last, so the time of every published edge is in.
+    m_edges.store(edge + 1, std::memory_order_release);
+}
+
+Snapshot Encoder::snapshot() const {
+    Snapshot snapshot;
+    snapshot.time = Clock::now();
+    // Retried while an edge is being written, including one that reuses a slot of the history being read.
+    uint64_t edges;
+    do {
+        edges = m_edges.load(std::memory_order_acquire);
+        snapshot.count = m_count.load(std::memory_order_relaxed);
+        snapshot.direction = m_direction.load(std::memory_order_relaxed);
+        snapshot.lastEdge = edges >= 1 ? m_times[(edges - 1) % HISTORY].load(std::memory_order_relaxed) : 0;
+        snapshot.cycleStart = edges > CYCLE ? m_times[(edges - 1 - CYCLE) % HISTORY].load(std::memory_order_relaxed) : 0;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (m_state.load(std::memory_order_relaxed) >> EDGE_SHIFT != edges);
+    snapshot.errors = m_errors.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+} // namespace encoder
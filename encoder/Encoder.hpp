@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "utils/Clock.hpp"
+#include "wiring/Pin.hpp"
+
+namespace encoder {
+
+// What the estimators need of the encoder at one moment.
+struct Snapshot {
+    Clock::time_point time;
+    int64_t count;
+    // The edge of the last change and the one a full cycle of 4 before it, 0 until there are that many.
+    Clock::rep lastEdge;
+    Clock::rep cycleStart;
+    // The direction of the last change, 1 or -1.
+    int direction;
+    // Edges where a pin reported the level it already had, so an even number of edges were missed.
+    uint64_t errors;
+};
+
+// A quadrature encoder on two GPIO pins, counting every edge of both (x4 decoding).
+// The alerts only update atomics, with no locks, so pigpio's alert thread keeps up with edge rates of tens of kHz.
+// Edges are published one at a time after their time is stored, and a snapshot taken while one is being written is
+// retried, so the count and the edge times in a snapshot always belong together.
+class Encoder {
+public:
+    Encoder(int pinA, int pinB, Clock::duration glitch = {});
+    ~Encoder();
+
+    Encoder(const Encoder&) = delete;
+    Encoder& operator=(const Encoder&) = delete;
+
+    Snapshot snapshot() const;
+
+private:
+    // The time of the edges, indexed by the edge count, so the period of a full cycle can be read back.
+    static constexpr size_t HISTORY = 8;
+
+    void edge(int channel, bool level, Clock::time_point time);
+
+    wiring::InputPin m_pinA;
+    wiring::InputPin m_pinB;
+
+    // The levels of A in bit 0 and B in bit 1, and the edges so far above them, which puts the edges in line.
+    std::atomic<uint64_t> m_state;
+    // The edges that have been published. Behind the ones in m_state only while an edge is being written.
+    std::atomic<uint64_t> m_edges = 0;
+    std::atomic<int64_t> m_count = 0;
+    std::array<std::atomic<Clock::rep>, HISTORY> m_times = {};
+    std::atomic<int> m_direction = 1;
+    std::atomic<uint64_t> m_errors = 0;
+};
+
+} // namespace encoder
@@ -0,0 +1,101 @@
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+#include "utils/Other.hpp"
+
+#include "Sensor.hpp"
+
+namespace encoder {
+
+enum SensorValue : size_t {
+    COUNT,
+    POSITION,
+    VELOCITY,
+    ERRORS,
+    NUM_VALUES
+};
+
+constexpr float CYCLE = 4.0f;
+
+Estimator estimatorFromString(std::string_view estimator) {
+    const auto estimatorStr = toupper(estimator);
+    if (estimatorStr == "AUTO")       return Estimator::AUTO;
+    if (estimatorStr == "PERIOD")     return Estimator::PERIOD;
+    if (estimatorStr == "DIFFERENCE") return Estimator::DIFFERENCE;
+    throw std::invalid_argument(std::format("encoder::estimatorFromString(): Unrecognized estimator: {}", estimator));
+}
+
+Sensor::Sensor(const SensorConfig& config, bool live) :
+    pi::Input("Encoder", NUM_VALUES),
+    m_estimator(config.estimator),
+    m_threshold(config.threshold),
+    m_scale(config.scale),
+    m_timeout(config.timeout),
+    m_encoder(live ? std::make_unique<Encoder>(config.pinA, config.pinB, config.glitch) : nullptr)
+{}
+
+void Sensor::poll() {
+    if (m_encoder == nullptr) {
+        return;
+    }
+
+    const auto snapshot = m_encoder->snapshot();
+    record(snapshot);
+    update(snapshot);
+}
+
+void Sensor::replay(std::span<const std::byte> event) {
+    if (event.size() != sizeof(Snapshot)) {
+        throw std::invalid_argument(std::format("encoder::Sensor::replay(): Events must be {} bytes", sizeof(Snapshot)));
+    }
+    Snapshot snapshot;
+    std::memcpy(&snapshot, event.data(), sizeof(Snapshot));
+    update(snapshot);
+}
+
+float Sensor::velocity(const Snapshot& snapshot) const {
+    if (snapshot.lastEdge == 0 || m_last.time == Clock::time_point()) {
+        return 0.0f;
+    }
+    const auto sinceEdge = snapshot.time - Clock::time_point(Clock::duration(snapshot.lastEdge));
+    if (sinceEdge > m_timeout) {
+        return 0.0f;
+    }
+
+    const auto counts = snapshot.count - m_last.count;
+    const bool fast = std::abs(counts) >= m_threshold;
+    if (m_estimator == Estimator::DIFFERENCE || (m_estimator == Estimator::AUTO && fast) || snapshot.cycleStart == 0) {
+        // Between the last edges of each tick the time is exactly that of the counts, with no partial count at either end.
+        auto elapsed = Clock::duration(snapshot.lastEdge - m_last.lastEdge);
+        if (m_last.lastEdge == 0 || elapsed <= Clock::duration::zero()) {
+            elapsed = snapshot.time - m_last.time;
+        }
+        return float(counts) / std::chrono::duration<float>(elapsed).count();
+    }
+
+    // A full cycle evens out the spacing of the A and B edges, which is rarely a perfect quarter.
+    auto period = std::chrono::duration<float>(Clock::duration(snapshot.lastEdge - snapshot.cycleStart)).count() / CYCLE;
+    // Without an edge for longer than that the wheel has slowed to at most a count in the time since.
+    period = std::max(period, std::chrono::duration<float>(sinceEdge).count());
+    return period > 0.0f ? float(snapshot.direction) / period : 0.0f;
+}
+
+void Sensor::update(const Snapshot& snapshot) {
+    m_values[VELOCITY] = velocity(snapshot) * m_scale;
+    m_values[COUNT] = float(snapshot.count);
+    m_values[POSITION] = float(snapshot.count) * m_scale;
+    m_values[ERRORS] = float(snapshot.errors);
+    m_last = snapshot;
+}
+
+size_t Sensor::index(std::string_view key) const {
+    if (key == "count")    return COUNT;
+    if (key == "position") return POSITION;
+    if (key == "velocity") return VELOCITY;
+    if (key == "errors")   return ERRORS;
+    throw std::invalid_argument(std::format("encoder::Sensor::index(): Unrecognized key: {}", key));
+}
+
+} // namespace encoder
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+
+#include "pi/Input.hpp"
+
+#include "Encoder.hpp"
+
+namespace encoder {
+
+enum class Estimator {
+    // The count difference when the wheel is fast and the edge period when it is slow.
+    AUTO,
+    PERIOD,
+    DIFFERENCE,
+};
+
+Estimator estimatorFromString(std::string_view estimator);
+
+struct SensorConfig {
+    int pinA = -1;
+    int pinB = -1;
+    Clock::duration glitch = {};
+    Estimator estimator = Estimator::AUTO;
+    // With AUTO, ticks with at least this many counts use the count difference.
+    int threshold = 8;
+    // Units per count, like the wheel's circumference over its counts per revolution.
+    float scale = 1.0f;
+    // Without an edge for this long the wheel is taken to have stopped.
+    Clock::duration timeout = std::chrono::milliseconds(250);
+};
+
+// Exports "count", "position" as the count times the scale, "velocity" in scale units per second
+// and "errors" as the edges that were missed.
+// The count difference measures the counts between the last edges of this tick and the last, which quantizes badly
+// when only a few counts go by. The period measures the time of the last full cycle of 4 edges, which is exact at
+// low speed but jittery at high speed. Every snapshot of the encoder is recorded as it is polled.
+class Sensor : public pi::Input {
+public:
+    Sensor(const SensorConfig& config, bool live = true);
+
+    void poll() override;
+
+    size_t index(std::string_view key) const override;
+
+    // Replays one Snapshot.
+    void replay(std::span<const std::byte> event) override;
+
+private:
+    void update(const Snapshot& snapshot);
+    // In counts per second.
+    float velocity(const Snapshot& snapshot) const;
+
+    const Estimator m_estimator;
+    const int m_threshold;
+    const float m_scale;
+    const Clock::duration m_timeout;
+    // Null when not live.
+    std::unique_ptr<Encoder> m_encoder;
+    Snapshot m_last = {};
+};
+
+} // namespace encoder
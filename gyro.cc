@@ -4,6 +4,7 @@
 #include <format>
 #include <map>
 #include <memory>
+#include <string>
 #include <thread>
 
 #include "gyro/Gyrometer.hpp"
@@ -55,14 +56,19 @@ public:
         parser.addOptional(period, "period", "The period to wait between updating the data.");
         parser.addOptional(calibrate, "calibrate", "Calibrate the gyrometer first.");
         parser.addOptional(test, "test", "Test the gyrometer against its factory trim.");
+        parser.addOptional(calibration, "calibration", "The calibration file to load, and to save to after calibrating.");
+        parser.addOptional(bias, "bias", "Estimate the gyro bias first. The gyrometer must be still.");
+        parser.addOptional(warmup, "warmup", "Fit the gyro bias to the temperature over this long first. The gyrometer must be still and warming up.");
         // TODO: Add options for accel max and gyro max.
 
         examples.push_back(std::format("{} Accel --calibrate --period 10ms", prgmName));
         examples.push_back(std::format("{} Gyro --test", prgmName));
+        examples.push_back(std::format("{} Gyro --bias --calibration gyro.cal", prgmName));
+        examples.push_back(std::format("{} Gyro --warmup 1800s --calibration gyro.cal", prgmName));
     }
 
     void init() override {
-        g = std::make_unique<Gyrometer>();
+        g = std::make_unique<Gyrometer>(GyroRange::DEG_250, AccelRange::G_2, calibration);
        
         if (test) {
             if (mode == GyroMode::ACCEL) {
@@ -82,6 +88,20 @@ public:
             // TODO: Choose calibration.
             g->calibrate();
         }
+
+        const bool fit = warmup.ns() > 0ns;
+        if (fit && !g->fitTemperature(warmup.ns())) {
+            logger.warning() << "Keeping the previous temperature model";
+        }
+
+        if (bias && !g->estimateBias()) {
+            logger.warning() << "Keeping the previous gyro bias";
+        }
+
+        if ((calibrate || bias || fit) && !calibration.empty()) {
+            g->calibration().save(calibration);
+            logger.info() << "Saved the calibration to " << calibration;
+        }
     }
     
     void loop() override {
@@ -135,6 +155,9 @@ private:
     Duration period = 10ms;
     bool calibrate = false;
     bool test = false;
+    bool bias = false;
+    Duration warmup = 0ns;
+    std::string calibration;
     std::unique_ptr<Gyrometer> g;
 };
 
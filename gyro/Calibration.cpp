@@ -0,0 +1,86 @@
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+#include "utils/Logger.hpp"
+
+#include "Calibration.hpp"
+
+namespace gyro {
+
+constexpr std::array<char, 8> CAL_MAGIC = {'R', 'A', 'P', 'P', 'Y', 'C', 'A', 'L'};
+
+struct CalHeader {
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t checksum;
+};
+
+static_assert(std::is_trivially_copyable_v<Calibration>);
+
+// FNV-1a, which is plenty to catch a truncated or scribbled file.
+static uint32_t checksum(const Calibration& calibration) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&calibration);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(Calibration); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+float Calibration::gyroBiasAt(size_t axis, float temperature) const {
+    const auto dt = temperature - referenceTemperature;
+    return gyroBias[axis] + (gyroTempCoeff[axis] + gyroTempCurve[axis] * dt) * dt;
+}
+
+float Calibration::gyroScaleAt(size_t axis, float temperature) const {
+    return 1.0f + gyroScaleCoeff[axis] * (temperature - referenceTemperature);
+}
+
+std::optional<Calibration> Calibration::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        logger.debug() << "gyro::Calibration::load(): No calibration at " << path;
+        return std::nullopt;
+    }
+
+    CalHeader header;
+    Calibration calibration;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    file.read(reinterpret_cast<char*>(&calibration), sizeof(calibration));
+    if (!file || header.magic != CAL_MAGIC) {
+        logger.warning() << "gyro::Calibration::load(): Not a calibration: " << path;
+        return std::nullopt;
+    }
+    if (header.version != VERSION || header.size != sizeof(Calibration)) {
+        logger.warning() << std::format("gyro::Calibration::load(): Version {} is not {}: {}", header.version, VERSION, path);
+        return std::nullopt;
+    }
+    if (header.checksum != checksum(calibration)) {
+        logger.warning() << "gyro::Calibration::load(): Corrupt calibration: " << path;
+        return std::nullopt;
+    }
+    return calibration;
+}
+
+void Calibration::save(const std::string& path) const {
+    const auto tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        const CalHeader header = {CAL_MAGIC, VERSION, sizeof(Calibration), checksum(*this)};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(this), sizeof(*this));
+        if (!file) {
+            throw std::runtime_error(std::format("gyro::Calibration::save(): Could not write {}", tmpPath));
+        }
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error(std::format("gyro::Calibration::save(): Could not replace {}: {}", path, std::strerror(errno)));
+    }
+}
+
+} // namespace gyro
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace gyro {
+
+constexpr size_t NUM_AXES = 3;
+constexpr size_t NUM_DIRS = 2;
+
+// Everything needed to turn raw readings into physical ones.
+// Stored as a small versioned binary file, so loading it at startup costs a single read.
+struct Calibration {
+    static constexpr uint32_t VERSION = 2;
+
+    // The raw readings of each axis pointing down and up, the accelerometer at 1 g on its 2 g range and the gyro at 1 deg/s.
+    std::array<std::array<int16_t, NUM_DIRS>, NUM_AXES> gyroAdj = {{
+        {{ -131, 131 }},
+        {{ -131, 131 }},
+        {{ -131, 131 }}
+    }};
+    std::array<std::array<int16_t, NUM_DIRS>, NUM_AXES> accelAdj = {{
+        {{ 16640, -16128 }},
+        {{ 16128, -16640 }},
+        {{ 15360, -17664 }}
+    }};
+
+    // The gyro reading in deg/s at rest at the reference temperature.
+    std::array<float, NUM_AXES> gyroBias = {};
+    // How much the gyro bias changes in deg/s per C away from the reference temperature,
+    // and the curve of that change in deg/s per C squared.
+    std::array<float, NUM_AXES> gyroTempCoeff = {};
+    std::array<float, NUM_AXES> gyroTempCurve = {};
+    // How much the gyro sensitivity changes per C, as a fraction of it at the reference temperature.
+    // Nothing at rest shows it, so it comes from the datasheet or a turntable rather than the warm up fit.
+    std::array<float, NUM_AXES> gyroScaleCoeff = {};
+    float referenceTemperature = 25.0f;
+
+    // The gyro bias in deg/s and the sensitivity relative to the reference at the temperature in C.
+    float gyroBiasAt(size_t axis, float temperature) const;
+    float gyroScaleAt(size_t axis, float temperature) const;
+
+    // Returns nothing if the file is missing, from another version or corrupt.
+    static std::optional<Calibration> load(const std::string& path);
+
+    // Replaces the file in one step, so a crash never leaves half a calibration behind.
+    void save(const std::string& path) const;
+};
+
+} // namespace gyro
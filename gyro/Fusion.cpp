@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <numbers>
+#include <stdexcept>
+
+#include "utils/Other.hpp"
+
+#include "Fusion.hpp"
+
+namespace gyro {
+
+constexpr float DEG_TO_RAD = std::numbers::pi_v<float> / 180.0f;
+constexpr float RAD_TO_DEG = 180.0f / std::numbers::pi_v<float>;
+
+// The bit trick estimate of 1 / sqrt(x) refined by two Newton steps, which is accurate to about 1e-6.
+constexpr float invSqrt(float x) {
+    const float half = 0.5f * x;
+    float y = std::bit_cast<float>(0x5F375A86 - (std::bit_cast<uint32_t>(x) >> 1));
+    y *= 1.5f - half * y * y;
+    y *= 1.5f - half * y * y;
+    return y;
+}
+
+FusionFilter fusionFilterFromString(std::string_view filter) {
+    const auto filterStr = toupper(filter);
+    if (filterStr == "COMPLEMENTARY") return FusionFilter::COMPLEMENTARY;
+    if (filterStr == "MADGWICK")      return FusionFilter::MADGWICK;
+    throw std::invalid_argument(std::format("gyro::fusionFilterFromString(): Unrecognized filter: {}", filter));
+}
+
+Fusion::Fusion(FusionFilter filter, float gain) :
+    m_filter(filter),
+    m_gain(gain)
+{
+    if (gain < 0.0f || (filter == FusionFilter::COMPLEMENTARY && gain > 1.0f)) {
+        throw std::invalid_argument(std::format("gyro::Fusion::Fusion(): Gain out of range: {}", gain));
+    }
+    reset();
+}
+
+void Fusion::reset() {
+    m_q = {1.0f, 0.0f, 0.0f, 0.0f};
+    m_euler = {};
+}
+
+void Fusion::update(const std::array<float, 3>& rot, const std::array<float, 3>& accel, float dt) {
+    switch (m_filter) {
+    case FusionFilter::COMPLEMENTARY: updateComplementary(rot, accel, dt); break;
+    case FusionFilter::MADGWICK:      updateMadgwick(rot, accel, dt); break;
+    }
+}
+
+void Fusion::updateComplementary(const std::array<float, 3>& rot, const std::array<float, 3>& accel, float dt) {
+    for (size_t i = 0; i < m_euler.size(); i++) {
+        m_euler[i] += rot[i] * dt;
+    }
+    m_euler[2] = std::remainder(m_euler[2], 360.0f);
+
+    // Gravity only says which way is down, so the heading is left to the gyro.
+    const auto& [ax, ay, az] = accel;
+    const auto horizontal = ay * ay + az * az;
+    if (horizontal + ax * ax == 0.0f) {
+        return;
+    }
+    const auto accelRoll = std::atan2(ay, az) * RAD_TO_DEG;
+    const auto accelPitch = std::atan2(-ax, horizontal * invSqrt(horizontal)) * RAD_TO_DEG;
+    m_euler[0] = m_gain * m_euler[0] + (1.0f - m_gain) * accelRoll;
+    m_euler[1] = m_gain * m_euler[1] + (1.0f - m_gain) * accelPitch;
+}
+
+void Fusion::updateMadgwick(const std::array<float, 3>& rot, const std::array<float, 3>& accel, float dt) {
+    auto& [q0, q1, q2, q3] = m_q;
+    const auto gx = rot[0] * DEG_TO_RAD;
+    const auto gy = rot[1] * DEG_TO_RAD;
+    const auto gz = rot[2] * DEG_TO_RAD;
+
+    // The rate of change of the quaternion from the gyro.
+    auto qDot0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    auto qDot1 = 0.5f * ( q0 * gx + q2 * gz - q3 * gy);
+    auto qDot2 = 0.5f * ( q0 * gy - q1 * gz + q3 * gx);
+    auto qDot3 = 0.5f * ( q0 * gz + q1 * gy - q2 * gx);
+
+    auto [ax, ay, az] = accel;
+    const auto accelNorm = ax * ax + ay * ay + az * az;
+    if (accelNorm != 0.0f) {
+        const auto recip = invSqrt(accelNorm);
+        ax *= recip;
+        ay *= recip;
+        az *= recip;
+
+        // The gradient of the error between where the quaternion and the accelerometer say gravity is.
+        const auto _2q0 = 2.0f * q0;
+        const auto _2q1 = 2.0f * q1;
+        const auto _2q2 = 2.0f * q2;
+        const auto _2q3 = 2.0f * q3;
+        const auto _4q0 = 4.0f * q0;
+        const auto _4q1 = 4.0f * q1;
+        const auto _4q2 = 4.0f * q2;
+        const auto _8q1 = 8.0f * q1;
+        const auto _8q2 = 8.0f * q2;
+        const auto q0q0 = q0 * q0;
+        const auto q1q1 = q1 * q1;
+        const auto q2q2 = q2 * q2;
+        const auto q3q3 = q3 * q3;
+
+        auto s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+        auto s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+        auto s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+        auto s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+        const auto sNorm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (sNorm != 0.0f) {
+            const auto step = m_gain * invSqrt(sNorm);
+            qDot0 -= step * s0;
+            qDot1 -= step * s1;
+            qDot2 -= step * s2;
+            qDot3 -= step * s3;
+        }
+    }
+
+    q0 += qDot0 * dt;
+    q1 += qDot1 * dt;
+    q2 += qDot2 * dt;
+    q3 += qDot3 * dt;
+    const auto recip = invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    for (auto& q : m_q) {
+        q *= recip;
+    }
+
+    m_euler[0] = std::atan2(2.0f * (q0 * q1 + q2 * q3), 1.0f - 2.0f * (q1 * q1 + q2 * q2)) * RAD_TO_DEG;
+    m_euler[1] = std::asin(std::clamp(2.0f * (q0 * q2 - q3 * q1), -1.0f, 1.0f)) * RAD_TO_DEG;
+    m_euler[2] = std::atan2(2.0f * (q0 * q3 + q1 * q2), 1.0f - 2.0f * (q2 * q2 + q3 * q3)) * RAD_TO_DEG;
+}
+
+} // namespace gyro
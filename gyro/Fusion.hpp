@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace gyro {
+
+enum class FusionFilter : uint8_t {
+    // Integrates the gyro and pulls roll and pitch towards the accelerometer by 1 - gain each sample.
+    COMPLEMENTARY,
+    // Madgwick's gradient descent filter on a quaternion, gain is beta.
+    MADGWICK
+};
+
+FusionFilter fusionFilterFromString(std::string_view filter);
+
+// Fuses gyro and accelerometer samples into an orientation.
+// The state is a fixed size and updating never allocates, so it can run at the sensor rate.
+class Fusion {
+public:
+    static constexpr float COMPLEMENTARY_GAIN = 0.98f;
+    static constexpr float MADGWICK_GAIN = 0.1f;
+
+    Fusion(FusionFilter filter, float gain);
+
+    // Levels the orientation and zeroes the heading.
+    void reset();
+
+    // rot is in deg/s, accel is the measured acceleration in any unit with +Z up when flat and dt is in seconds.
+    void update(const std::array<float, 3>& rot, const std::array<float, 3>& accel, float dt);
+
+    // In degrees.
+    float roll() const { return m_euler[0]; }
+    float pitch() const { return m_euler[1]; }
+    float yaw() const { return m_euler[2]; }
+
+    // The orientation as w, x, y, z.
+    const std::array<float, 4>& quaternion() const { return m_q; }
+
+private:
+    void updateComplementary(const std::array<float, 3>& rot, const std::array<float, 3>& accel, float dt);
+    void updateMadgwick(const std::array<float, 3>& rot, const std::array<float, 3>& accel, float dt);
+
+    const FusionFilter m_filter;
+    const float m_gain;
+    std::array<float, 4> m_q;
+    std::array<float, 3> m_euler;
+};
+
+} // namespace gyro
@@ -1,9 +1,21 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstdint>
-
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "utils/Clock.hpp"
+#include "utils/Function.hpp"
+#include "utils/SpscQueue.hpp"
+#include "utils/Statistics.hpp"
 #include "wiring/I2cDevice.hpp"
+#include "wiring/Pin.hpp"
+
+#include "Calibration.hpp"
+#include "Temperature.hpp"
 
 namespace gyro {
 
@@ -21,13 +33,38 @@ enum class AccelRange : uint8_t {
     G_16 = 3,
 };
 
-constexpr size_t NUM_AXES = 3;
-constexpr size_t NUM_DIRS = 2;
+// Every measurement as the sensor reports it.
+struct RawSample {
+    Clock::time_point time;
+    std::array<int16_t, NUM_AXES> accel;
+    int16_t temperature;
+    std::array<int16_t, NUM_AXES> rot;
+};
 
-// Can only read values roughly 2000x per second.
+// Every measurement scaled like the per axis getters, with the temperature in C.
+struct Sample {
+    Clock::time_point time;
+    std::array<float, NUM_AXES> accel;
+    float temperature;
+    std::array<float, NUM_AXES> rot;
+};
+
+// Can only read values roughly 2000x per second, so prefer sample() which reads everything in one go.
+// To get every sample at the full rate, stream them from the sensor's FIFO or its data ready interrupt instead.
 class Gyrometer {
 public:
-    Gyrometer(GyroRange gyroRange = GyroRange::DEG_250, AccelRange accelRange = AccelRange::G_2);
+    static constexpr size_t STREAM_SIZE = 1024;
+
+    using Hook = Function<void(const RawSample&)>;
+
+    static constexpr uint8_t ADDRESS = 0x68;
+    // With AD0 pulled high, so two can share a bus or a mux channel.
+    static constexpr uint8_t ALT_ADDRESS = 0x69;
+
+    // Loads the calibration from calibrationPath if it is given and valid, and uses the defaults otherwise.
+    // channel is the TCA9548A channel the sensor is behind, if any.
+    Gyrometer(GyroRange gyroRange = GyroRange::DEG_250, AccelRange accelRange = AccelRange::G_2, const std::string& calibrationPath = "",
+        uint8_t address = ADDRESS, int channel = wiring::I2cBus::NO_CHANNEL);
     ~Gyrometer();
 
     int16_t rawRotX() const;
@@ -46,14 +83,94 @@ public:
     float accelY() const;
     float accelZ() const;
 
+    // Reads every measurement in one burst, so they are all from the same instant.
+    RawSample rawSample() const;
+    Sample sample() const;
+
+    Sample convert(const RawSample& raw) const;
+
+    // Has the sensor queue samples at rate Hz in its FIFO and drains it from the I2C bus' scheduler thread.
+    // dlpf sets the low pass filter from 0 (off, 8 kHz gyro) to 6 (5 Hz), anything but 0 samples at up to 1 kHz.
+    void startStream(int rate, uint8_t dlpf = 1);
+
+    // Streams by reading each sample once when the sensor's INT pin, wired to pin, signals it is ready.
+    // The samples are stamped with the time of the interrupt.
+    void startInterrupt(int pin, int rate, uint8_t dlpf = 1);
+
+    void stopStream();
+    bool streaming() const { return m_streaming.load(std::memory_order_relaxed); }
+
+    // Calls hook from the thread reading the stream as each sample arrives, before it is queued.
+    // Must be set before the stream starts. A FIFO stream is then drained every sample period instead of in batches.
+    void setHook(Hook hook) { m_hook = std::move(hook); }
+
+    // Takes the oldest streamed sample. Must only be called from the thread that starts the stream.
+    bool pop(RawSample& raw) { return m_stream.pop(raw); }
+
+    // Times the sensor's FIFO filled up and lost samples.
+    size_t overflows() const { return m_overflows.load(std::memory_order_relaxed); }
+    // Samples lost because they were not popped in time.
+    size_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // The mean time from an interrupt to its sample having been read.
+    Clock::duration latency() const;
+
+    // Interactively calibrates the accelerometer.
     void calibrate();
 
+    // Estimates the gyro bias from a burst of samples, which takes about half a second.
+    // Leaves the bias alone and returns false if the sensor was moving.
+    bool estimateBias();
+
+    // Fits how the gyro bias drifts with the temperature while the sensor sits still for duration.
+    // It has to warm up by a few C meanwhile, for example from a cold start with the motors running.
+    // Windows where the sensor moved are skipped. Leaves the calibration alone and returns false if the fit failed.
+    bool fitTemperature(Clock::duration duration);
+
+    const Calibration& calibration() const { return m_calibration; }
+    void setCalibration(const Calibration& calibration);
+
     void selfTest() const;
 
 private:
+    // Stops any stream and sets the sample rate.
+    void configure(int rate, uint8_t dlpf);
+    void resetFifo() const;
+    void drain();
+    void interrupt(bool level, Clock::time_point time);
+
+    // One axis of the gyro, corrected for the temperature like the samples are.
+    float rot(size_t axis) const;
+
+    // Reads samples in bursts and returns the stats of each accelerometer axis in raw units.
+    // With histograms, every sample is also counted into the one of its axis.
+    std::array<RunningStats, NUM_AXES> accelStats(size_t samples, std::array<Histogram, NUM_AXES>* histograms = nullptr) const;
+
+    // A histogram per accelerometer axis, spread around a short read so the bins are fine enough for the noise.
+    std::array<Histogram, NUM_AXES> accelHistograms() const;
+
+    // Reads samples in bursts and returns the stats of each gyro axis in raw units, with the mean temperature in C.
+    std::array<RunningStats, NUM_AXES> rotStats(size_t samples, float& temperature) const;
+
     const wiring::I2cDevice m_device;
+    const GyroRange m_gyroRange;
+    const AccelRange m_accelRange;
+    Calibration m_calibration;
+    // The calibration scaled to the ranges.
     std::array<std::array<int16_t, NUM_DIRS>, NUM_AXES> m_gyroAdj;
     std::array<std::array<int16_t, NUM_DIRS>, NUM_AXES> m_accelAdj;
+    TemperatureTable m_temperatureTable;
+
+    Clock::duration m_period = {};
+    std::atomic<bool> m_streaming = false;
+    std::atomic<size_t> m_overflows = 0;
+    std::atomic<size_t> m_dropped = 0;
+    std::atomic<size_t> m_interrupts = 0;
+    std::atomic<Clock::rep> m_latency = 0;
+    std::optional<wiring::I2cBus::JobId> m_drainJob;
+    std::unique_ptr<wiring::InputPin> m_interrupt;
+    Hook m_hook;
+    SpscQueue<RawSample, STREAM_SIZE> m_stream;
 };
 
 } // namespace gyro
@@ -0,0 +1,45 @@
+#include <cmath>
+#include <format>
+#include <stdexcept>
+
+#include "Impact.hpp"
+
+namespace gyro {
+
+constexpr float RELEASE = 0.5f;
+
+ImpactDetector::ImpactDetector(float threshold, float jerk) :
+    m_threshold(threshold),
+    m_jerk(jerk)
+{
+    if (threshold <= 0.0f || jerk < 0.0f) {
+        throw std::invalid_argument(std::format("gyro::ImpactDetector::ImpactDetector(): Invalid threshold {} or jerk {}", threshold, jerk));
+    }
+}
+
+bool ImpactDetector::update(const Sample& sample) {
+    const auto magnitude = std::hypot(sample.accel[0], sample.accel[1], sample.accel[2]);
+    const auto deviation = std::abs(magnitude - 1.0f);
+
+    auto jerk = 0.0f;
+    const auto dt = std::chrono::duration<float>(sample.time - m_lastTime).count();
+    if (m_lastTime != Clock::time_point() && dt > 0.0f) {
+        jerk = std::abs(magnitude - m_lastMagnitude) / dt;
+    }
+    m_lastMagnitude = magnitude;
+    m_lastTime = sample.time;
+
+    const bool jerking = m_jerk > 0.0f && jerk > m_jerk;
+    if (!m_active) {
+        m_active = deviation > m_threshold || jerking;
+        return m_active;
+    }
+
+    const bool calmJerk = m_jerk == 0.0f || jerk < RELEASE * m_jerk;
+    if (deviation < RELEASE * m_threshold && calmJerk) {
+        m_active = false;
+    }
+    return false;
+}
+
+} // namespace gyro
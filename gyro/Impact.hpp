@@ -0,0 +1,29 @@
+#pragma once
+
+#include "utils/Clock.hpp"
+
+#include "Gyrometer.hpp"
+
+namespace gyro {
+
+// Detects impacts in the acceleration, from how far it strays from 1 g or how fast it changes.
+// An impact starts when either goes over its threshold and ends once both are back under half of it.
+class ImpactDetector {
+public:
+    // threshold is in g away from 1 g and jerk is in g/s. A jerk of 0 only uses the threshold.
+    ImpactDetector(float threshold, float jerk);
+
+    // Returns true for the sample that starts an impact.
+    bool update(const Sample& sample);
+
+    bool active() const { return m_active; }
+
+private:
+    const float m_threshold;
+    const float m_jerk;
+    bool m_active = false;
+    float m_lastMagnitude = 1.0f;
+    Clock::time_point m_lastTime;
+};
+
+} // namespace gyro
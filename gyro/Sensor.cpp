@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+#include "motor/EmergencyStop.hpp"
+#include "utils/Logger.hpp"
+
+#include "Sensor.hpp"
+
+namespace gyro {
+
+enum SensorValue : size_t {
+    ACCEL_X,
+    ACCEL_Y,
+    ACCEL_Z,
+    ROT_X,
+    ROT_Y,
+    ROT_Z,
+    TEMPERATURE,
+    ROLL,
+    PITCH,
+    YAW,
+    VIBRATION_FREQUENCY,
+    VIBRATION_RMS,
+    VIBRATION_LOW,
+    VIBRATION_MID,
+    VIBRATION_HIGH,
+    IMPACT_ACTIVE,
+    IMPACT_COUNT,
+    IMPACT_LATENCY,
+    IMPACT_LATENCY_MAX,
+    NUM_VALUES
+};
+
+// Longer gaps between samples, like after a stall, are not integrated.
+constexpr float MAX_DT = 0.1f;
+
+Sensor::Sensor(const SensorConfig& config, bool live) :
+    pi::Input("Gyro", NUM_VALUES),
+    m_gyrometer(live ? std::make_unique<Gyrometer>(GyroRange::DEG_250, AccelRange::G_2, config.calibration, config.address, config.channel) : nullptr),
+    m_period(std::chrono::nanoseconds(1'000'000'000LL / std::max(config.rate, 1))),
+    m_fusion(config.filter, config.gain),
+    m_vibration(config.vibrationWindow, config.vibrationHop, float(config.rate), config.vibrationBands)
+{
+    if (config.impact) {
+        m_impact.emplace(config.impactThreshold, config.impactJerk);
+        motor::EmergencyStop::get().setHold(config.impactHold);
+    }
+
+    if (m_gyrometer != nullptr) {
+        if (m_impact) {
+            m_gyrometer->setHook([this](const RawSample& raw) {
+                if (m_impact->update(m_gyrometer->convert(raw))) {
+                    motor::EmergencyStop::get().trip(raw.time);
+                }
+            });
+        }
+        if (config.estimateBias) {
+            m_gyrometer->estimateBias();
+        }
+        if (config.interruptPin >= 0) {
+            m_gyrometer->startInterrupt(config.interruptPin, config.rate);
+        }
+        else {
+            m_gyrometer->startStream(config.rate);
+        }
+    }
+    publish();
+}
+
+Sensor::~Sensor() {
+    if (m_gyrometer != nullptr) {
+        m_gyrometer->stopStream();
+    }
+}
+
+void Sensor::poll() {
+    if (m_gyrometer == nullptr) {
+        return;
+    }
+
+    RawSample raw;
+    while (m_gyrometer->pop(raw)) {
+        const auto sample = m_gyrometer->convert(raw);
+        record(sample);
+        update(sample);
+    }
+    m_vibration.process();
+
+    const auto& stop = motor::EmergencyStop::get();
+    if (m_impact && stop.trips() != m_impacts) {
+        m_impacts = stop.trips();
+        logger.warning() << std::format("gyro::Sensor::poll(): Impact, stopped the motors in {} us",
+            std::chrono::duration_cast<std::chrono::microseconds>(stop.maxLatency()).count());
+    }
+
+    const auto overflows = m_gyrometer->overflows();
+    const auto dropped = m_gyrometer->dropped();
+    if (overflows != m_overflows || dropped != m_dropped) {
+        logger.warning() << std::format("gyro::Sensor::poll(): Lost samples, {} overflows and {} dropped", overflows - m_overflows, dropped - m_dropped);
+        m_overflows = overflows;
+        m_dropped = dropped;
+    }
+    publish();
+}
+
+void Sensor::replay(std::span<const std::byte> event) {
+    if (event.size() != sizeof(Sample)) {
+        throw std::invalid_argument(std::format("gyro::Sensor::replay(): Events must be {} bytes", sizeof(Sample)));
+    }
+    Sample sample;
+    std::memcpy(&sample, event.data(), sizeof(Sample));
+    update(sample);
+    m_vibration.process();
+    publish();
+}
+
+void Sensor::update(const Sample& sample) {
+    auto dt = std::chrono::duration<float>(m_period).count();
+    if (m_last.time != Clock::time_point()) {
+        dt = std::chrono::duration<float>(sample.time - m_last.time).count();
+    }
+
+    // The Gyrometer reports acceleration pointing down, while the fusion wants the measured force pointing up.
+    const std::array<float, NUM_AXES> accel = {-sample.accel[0], -sample.accel[1], -sample.accel[2]};
+    if (dt > 0.0f && dt <= MAX_DT) {
+        m_fusion.update(sample.rot, accel, dt);
+    }
+    m_vibration.add(std::hypot(accel[0], accel[1], accel[2]));
+    m_last = sample;
+}
+
+void Sensor::publish() {
+    for (size_t i = 0; i < NUM_AXES; i++) {
+        m_values[ACCEL_X + i] = m_last.accel[i];
+        m_values[ROT_X + i] = m_last.rot[i];
+    }
+    m_values[TEMPERATURE] = m_last.temperature;
+    m_values[ROLL] = m_fusion.roll();
+    m_values[PITCH] = m_fusion.pitch();
+    m_values[YAW] = m_fusion.yaw();
+    m_values[VIBRATION_FREQUENCY] = m_vibration.frequency();
+    m_values[VIBRATION_RMS] = m_vibration.rms();
+    for (size_t i = 0; i < m_vibration.bands().size(); i++) {
+        m_values[VIBRATION_LOW + i] = m_vibration.bands()[i];
+    }
+    if (m_impact) {
+        const auto& stop = motor::EmergencyStop::get();
+        m_values[IMPACT_ACTIVE] = stop.tripped() ? 1.0f : 0.0f;
+        m_values[IMPACT_COUNT] = float(stop.trips());
+        m_values[IMPACT_LATENCY] = std::chrono::duration<float, std::milli>(stop.meanLatency()).count();
+        m_values[IMPACT_LATENCY_MAX] = std::chrono::duration<float, std::milli>(stop.maxLatency()).count();
+    }
+}
+
+size_t Sensor::index(std::string_view key) const {
+    if (key == "accel.x")             return ACCEL_X;
+    if (key == "accel.y")             return ACCEL_Y;
+    if (key == "accel.z")             return ACCEL_Z;
+    if (key == "rot.x")               return ROT_X;
+    if (key == "rot.y")               return ROT_Y;
+    if (key == "rot.z")               return ROT_Z;
+    if (key == "temperature")         return TEMPERATURE;
+    if (key == "roll")                return ROLL;
+    if (key == "pitch")               return PITCH;
+    if (key == "yaw")                 return YAW;
+    if (key == "vibration.frequency") return VIBRATION_FREQUENCY;
+    if (key == "vibration.rms")       return VIBRATION_RMS;
+    if (key == "vibration.low")       return VIBRATION_LOW;
+    if (key == "vibration.mid")       return VIBRATION_MID;
+    if (key == "vibration.high")      return VIBRATION_HIGH;
+    if (key == "impact.active")       return IMPACT_ACTIVE;
+    if (key == "impact.count")        return IMPACT_COUNT;
+    if (key == "impact.latency")      return IMPACT_LATENCY;
+    if (key == "impact.latency-max")  return IMPACT_LATENCY_MAX;
+    throw std::invalid_argument(std::format("gyro::Sensor::index(): Unrecognized key: {}", key));
+}
+
+} // namespace gyro
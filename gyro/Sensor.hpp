@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "pi/Input.hpp"
+
+#include "Fusion.hpp"
+#include "Gyrometer.hpp"
+#include "Impact.hpp"
+#include "Vibration.hpp"
+
+namespace gyro {
+
+struct SensorConfig {
+    // 0x68, or 0x69 with AD0 high, behind the TCA9548A channel if there is one.
+    uint8_t address = Gyrometer::ADDRESS;
+    int channel = wiring::I2cBus::NO_CHANNEL;
+    int rate = 1000;
+    // Streams from the FIFO when negative.
+    int interruptPin = -1;
+    FusionFilter filter = FusionFilter::MADGWICK;
+    float gain = Fusion::MADGWICK_GAIN;
+    // Loaded at startup if given.
+    std::string calibration;
+    // Estimates the gyro bias at startup, which needs the car to sit still for half a second.
+    bool estimateBias = true;
+    // The vibration spectrum is taken of the last window samples every hop samples.
+    size_t vibrationWindow = 256;
+    size_t vibrationHop = 64;
+    // The edges in Hz of the low, mid and high vibration bands.
+    std::array<float, 2> vibrationBands = {20.0f, 100.0f};
+    // Trips the motors' emergency stop on impacts, straight from the streaming thread.
+    bool impact = false;
+    float impactThreshold = 2.0f;
+    float impactJerk = 0.0f;
+    Clock::duration impactHold = std::chrono::seconds(1);
+};
+
+// Exports "accel.x", "accel.y", "accel.z" in g and "rot.x", "rot.y", "rot.z" in deg/s, scaled like the Gyrometer,
+// "temperature" in C and the fused "roll", "pitch" and "yaw" in degrees.
+// The vibration of the acceleration magnitude is exported as "vibration.frequency" in Hz, "vibration.rms" in g
+// and the mean square of each band in g^2 as "vibration.low", "vibration.mid" and "vibration.high".
+// With impact detection on, "impact.active" is whether the motors are stopped, "impact.count" the number of impacts,
+// and "impact.latency" and "impact.latency-max" the ms from the impact being measured to the motors stopping.
+// Either way of streaming bounds that by the sample period, as the FIFO is drained every sample for the detector.
+// Every sample is fused and recorded as it is polled.
+class Sensor : public pi::Input {
+public:
+    Sensor(const SensorConfig& config, bool live = true);
+    virtual ~Sensor() override;
+
+    void poll() override;
+
+    size_t index(std::string_view key) const override;
+
+    // Replays one converted Sample.
+    void replay(std::span<const std::byte> event) override;
+
+private:
+    void update(const Sample& sample);
+    void publish();
+
+    // Null when not live.
+    std::unique_ptr<Gyrometer> m_gyrometer;
+    const Clock::duration m_period;
+    Fusion m_fusion;
+    Vibration m_vibration;
+    // Only touched by the streaming thread.
+    std::optional<ImpactDetector> m_impact;
+    size_t m_impacts = 0;
+    Sample m_last = {};
+    size_t m_overflows = 0;
+    size_t m_dropped = 0;
+};
+
+} // namespace gyro
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cmath>
+#include <format>
+
+#include "utils/Logger.hpp"
+
+#include "Temperature.hpp"
+
+namespace gyro {
+
+// Less than this and the drift is lost in the noise.
+constexpr float MIN_FIT_SPAN = 2.0f;
+// A curve needs a wide span, or it just fits the noise at the ends.
+constexpr float CURVE_FIT_SPAN = 10.0f;
+constexpr size_t MAX_TERMS = 3;
+
+void TemperatureTable::build(const Calibration& calibration, const std::array<std::array<int16_t, NUM_DIRS>, NUM_AXES>& gyroAdj) {
+    for (size_t i = 0; i < SIZE; i++) {
+        const auto temperature = MIN_TEMPERATURE + float(i);
+        auto& entry = m_entries[i];
+        for (size_t a = 0; a < NUM_AXES; a++) {
+            // The same mapping as remap(), from the raw readings at -1 and 1 deg/s, but as a gain and offset.
+            const auto range = float(gyroAdj[a][1] - gyroAdj[a][0]);
+            const auto scale = calibration.gyroScaleAt(a, temperature);
+            entry.gain[a] = 2.0f / range * scale;
+            entry.offset[a] = (-2.0f * gyroAdj[a][0] / range - 1.0f - calibration.gyroBiasAt(a, temperature)) * scale;
+        }
+    }
+}
+
+std::pair<size_t, float> TemperatureTable::locate(int16_t temperature) const {
+    const auto position = std::clamp(toCelsius(temperature) - MIN_TEMPERATURE, 0.0f, float(SIZE - 1));
+    const auto index = std::min(size_t(position), SIZE - 2);
+    return {index, position - float(index)};
+}
+
+float TemperatureTable::rot(size_t axis, int16_t raw, int16_t temperature) const {
+    const auto [index, frac] = locate(temperature);
+    const auto& lo = m_entries[index];
+    const auto& hi = m_entries[index + 1];
+    const auto gain = lo.gain[axis] + frac * (hi.gain[axis] - lo.gain[axis]);
+    const auto offset = lo.offset[axis] + frac * (hi.offset[axis] - lo.offset[axis]);
+    return raw * gain + offset;
+}
+
+std::array<float, NUM_AXES> TemperatureTable::rot(const std::array<int16_t, NUM_AXES>& raw, int16_t temperature) const {
+    const auto [index, frac] = locate(temperature);
+    const auto& lo = m_entries[index];
+    const auto& hi = m_entries[index + 1];
+
+    std::array<float, NUM_AXES> rot;
+    for (size_t a = 0; a < NUM_AXES; a++) {
+        const auto gain = lo.gain[a] + frac * (hi.gain[a] - lo.gain[a]);
+        const auto offset = lo.offset[a] + frac * (hi.offset[a] - lo.offset[a]);
+        rot[a] = raw[a] * gain + offset;
+    }
+    return rot;
+}
+
+void TemperatureFit::add(const std::array<float, NUM_AXES>& rot, float temperature) {
+    m_points.push_back({rot, temperature});
+}
+
+float TemperatureFit::span() const {
+    if (m_points.empty()) {
+        return 0.0f;
+    }
+    const auto [min, max] = std::minmax_element(m_points.begin(), m_points.end(), [](const Point& a, const Point& b) {
+        return a.temperature < b.temperature;
+    });
+    return max->temperature - min->temperature;
+}
+
+// Solves the normal equations of a least squares polynomial by Gaussian elimination.
+static std::array<double, MAX_TERMS> solve(std::array<std::array<double, MAX_TERMS + 1>, MAX_TERMS> m, size_t terms) {
+    for (size_t col = 0; col < terms; col++) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < terms; row++) {
+            if (std::abs(m[row][col]) > std::abs(m[pivot][col])) {
+                pivot = row;
+            }
+        }
+        std::swap(m[col], m[pivot]);
+
+        for (size_t row = col + 1; row < terms; row++) {
+            const auto factor = m[row][col] / m[col][col];
+            for (size_t k = col; k <= terms; k++) {
+                m[row][k] -= factor * m[col][k];
+            }
+        }
+    }
+
+    std::array<double, MAX_TERMS> coeffs = {};
+    for (size_t col = terms; col-- > 0;) {
+        auto sum = m[col][terms];
+        for (size_t k = col + 1; k < terms; k++) {
+            sum -= m[col][k] * coeffs[k];
+        }
+        coeffs[col] = sum / m[col][col];
+    }
+    return coeffs;
+}
+
+bool TemperatureFit::fit(Calibration& calibration) const {
+    const auto tempSpan = span();
+    if (tempSpan < MIN_FIT_SPAN) {
+        logger.warning() << std::format("gyro::TemperatureFit::fit(): The temperature only changed by {:.1f} C", tempSpan);
+        return false;
+    }
+    const size_t terms = tempSpan < CURVE_FIT_SPAN ? 2 : 3;
+
+    // Centering on the mean keeps the powers small, so the sums stay well conditioned.
+    double reference = 0.0;
+    for (const auto& point : m_points) {
+        reference += point.temperature;
+    }
+    reference /= double(m_points.size());
+
+    std::array<double, 2 * MAX_TERMS - 1> powers = {};
+    std::array<std::array<double, MAX_TERMS>, NUM_AXES> moments = {};
+    for (const auto& point : m_points) {
+        const auto dt = point.temperature - reference;
+        double power = 1.0;
+        for (size_t k = 0; k < 2 * terms - 1; k++) {
+            powers[k] += power;
+            if (k < terms) {
+                for (size_t a = 0; a < NUM_AXES; a++) {
+                    moments[a][k] += point.rot[a] * power;
+                }
+            }
+            power *= dt;
+        }
+    }
+
+    for (size_t a = 0; a < NUM_AXES; a++) {
+        std::array<std::array<double, MAX_TERMS + 1>, MAX_TERMS> m = {};
+        for (size_t row = 0; row < terms; row++) {
+            for (size_t col = 0; col < terms; col++) {
+                m[row][col] = powers[row + col];
+            }
+            m[row][terms] = moments[a][row];
+        }
+        const auto coeffs = solve(m, terms);
+        calibration.gyroBias[a] = float(coeffs[0]);
+        calibration.gyroTempCoeff[a] = float(coeffs[1]);
+        calibration.gyroTempCurve[a] = float(coeffs[2]);
+    }
+    calibration.referenceTemperature = float(reference);
+
+    logger.debug() << std::format("gyro::TemperatureFit::fit(): {} windows over {:.1f} C around {:.1f} C, slopes [{:.4f}, {:.4f}, {:.4f}] deg/s/C",
+        m_points.size(), tempSpan, reference, calibration.gyroTempCoeff[0], calibration.gyroTempCoeff[1], calibration.gyroTempCoeff[2]);
+    return true;
+}
+
+} // namespace gyro
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Calibration.hpp"
+
+namespace gyro {
+
+// The temperature register in C.
+constexpr float toCelsius(float raw) {
+    return raw / 340.0f + 36.53f;
+}
+
+// The calibrated gyro gain and offset of each axis at every temperature the sensor works at, one entry per C.
+// Correcting a reading is then a lookup, a lerp and a multiply add instead of evaluating the temperature model.
+class TemperatureTable {
+public:
+    static constexpr float MIN_TEMPERATURE = -40.0f;
+    static constexpr size_t SIZE = 128;
+
+    // gyroAdj is the calibration's gyroAdj scaled to the gyro range.
+    void build(const Calibration& calibration, const std::array<std::array<int16_t, NUM_DIRS>, NUM_AXES>& gyroAdj);
+
+    // The rotation in deg/s of the raw gyro readings at the raw temperature.
+    std::array<float, NUM_AXES> rot(const std::array<int16_t, NUM_AXES>& raw, int16_t temperature) const;
+    // The same for a single axis.
+    float rot(size_t axis, int16_t raw, int16_t temperature) const;
+
+private:
+    struct Entry {
+        std::array<float, NUM_AXES> gain;
+        std::array<float, NUM_AXES> offset;
+    };
+
+    // The entry below the raw temperature and how far it is towards the next one.
+    std::pair<size_t, float> locate(int16_t temperature) const;
+
+    std::array<Entry, SIZE> m_entries = {};
+};
+
+// Fits the gyro bias to the temperature from the mean readings of a still sensor as it warms up.
+class TemperatureFit {
+public:
+    // Adds the mean gyro reading in deg/s, with no bias removed, at the mean temperature in C.
+    void add(const std::array<float, NUM_AXES>& rot, float temperature);
+
+    size_t count() const { return m_points.size(); }
+    // The range of temperatures added so far.
+    float span() const;
+
+    // Fits the bias, its slope and with a wide enough span its curve around the mean temperature.
+    // Leaves the calibration alone and returns false if the temperature hardly changed.
+    bool fit(Calibration& calibration) const;
+
+private:
+    struct Point {
+        std::array<float, NUM_AXES> rot;
+        float temperature;
+    };
+
+    std::vector<Point> m_points;
+};
+
+} // namespace gyro
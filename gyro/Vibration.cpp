@@ -0,0 +1,94 @@
+#include <cmath>
+#include <format>
+#include <numbers>
+#include <stdexcept>
+
+#include "Vibration.hpp"
+
+namespace gyro {
+
+Vibration::Vibration(size_t window, size_t hop, float sampleRate, std::array<float, 2> bands) :
+    m_hop(hop),
+    m_sampleRate(sampleRate),
+    m_edges(bands),
+    m_fft(window),
+    m_samples(window, 0.0f),
+    m_window(window),
+    m_windowed(window),
+    m_power(m_fft.numBins())
+{
+    if (hop == 0 || hop > window || sampleRate <= 0.0f || bands[0] > bands[1]) {
+        throw std::invalid_argument(std::format("gyro::Vibration::Vibration(): Invalid hop {}, rate {} or bands [{}, {}]",
+            hop, sampleRate, bands[0], bands[1]));
+    }
+
+    // A Hann window, so the edges of the window do not show up as broadband noise.
+    for (size_t i = 0; i < window; i++) {
+        m_window[i] = 0.5f - 0.5f * std::cos(2.0f * std::numbers::pi_v<float> * i / window);
+    }
+}
+
+void Vibration::add(float value) {
+    m_samples[m_next] = value;
+    m_next = (m_next + 1) % m_samples.size();
+    m_count = std::min(m_count + 1, m_samples.size());
+    m_sinceLast++;
+}
+
+void Vibration::process() {
+    const auto size = m_samples.size();
+    if (m_count < size || m_sinceLast < m_hop) {
+        return;
+    }
+    m_sinceLast = 0;
+
+    float mean = 0.0f;
+    for (const auto value : m_samples) {
+        mean += value;
+    }
+    mean /= size;
+
+    // Unroll the ring oldest first, without its mean.
+    float squares = 0.0f;
+    for (size_t i = 0; i < size; i++) {
+        const auto value = m_samples[(m_next + i) % size] - mean;
+        squares += value * value;
+        m_windowed[i] = value * m_window[i];
+    }
+    m_rms = std::sqrt(squares / size);
+
+    m_fft.power(m_windowed, m_power);
+
+    float total = 0.0f;
+    size_t peak = 1;
+    std::array<float, 3> bands = {};
+    const auto binWidth = m_sampleRate / size;
+    for (size_t k = 1; k < m_power.size(); k++) {
+        const auto power = m_power[k];
+        total += power;
+        if (power > m_power[peak]) {
+            peak = k;
+        }
+        const auto freq = k * binWidth;
+        bands[freq < m_edges[0] ? 0 : freq < m_edges[1] ? 1 : 2] += power;
+    }
+
+    // Fit a parabola through the peak and its neighbours to get between the bins.
+    auto offset = 0.0f;
+    if (peak + 1 < m_power.size()) {
+        const auto left = m_power[peak - 1];
+        const auto right = m_power[peak + 1];
+        const auto denominator = left - 2.0f * m_power[peak] + right;
+        if (denominator != 0.0f) {
+            offset = 0.5f * (left - right) / denominator;
+        }
+    }
+    m_frequency = total > 0.0f ? (peak + offset) * binWidth : 0.0f;
+
+    // Split the mean square between the bands in proportion to their power.
+    for (size_t i = 0; i < bands.size(); i++) {
+        m_bands[i] = total > 0.0f ? bands[i] / total * m_rms * m_rms : 0.0f;
+    }
+}
+
+} // namespace gyro
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "utils/Fft.hpp"
+
+namespace gyro {
+
+// The spectrum of a sliding window of samples, such as the magnitude of the acceleration.
+// A window is analysed every hop samples, at most once per process(), so a stall never queues up transforms.
+class Vibration {
+public:
+    // bands are the two frequencies in Hz that split the spectrum into the low, mid and high bands.
+    Vibration(size_t window, size_t hop, float sampleRate, std::array<float, 2> bands);
+
+    void add(float value);
+
+    // Analyses the latest window if a hop has passed since the last one.
+    void process();
+
+    // The strongest frequency in Hz, ignoring 0 Hz.
+    float frequency() const { return m_frequency; }
+    // The RMS of the window with its mean removed.
+    float rms() const { return m_rms; }
+    // The mean square of each band, which add up to the square of the RMS.
+    const std::array<float, 3>& bands() const { return m_bands; }
+
+private:
+    const size_t m_hop;
+    const float m_sampleRate;
+    const std::array<float, 2> m_edges;
+    RealFft m_fft;
+    // A ring of the latest samples.
+    std::vector<float> m_samples;
+    size_t m_next = 0;
+    size_t m_count = 0;
+    size_t m_sinceLast = 0;
+    std::vector<float> m_window;
+    std::vector<float> m_windowed;
+    std::vector<float> m_power;
+
+    float m_frequency = 0.0f;
+    float m_rms = 0.0f;
+    std::array<float, 3> m_bands = {};
+};
+
+} // namespace gyro
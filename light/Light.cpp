@@ -64,6 +64,7 @@ Light Light::create(const boost::json::object& cfg) {
     
     wiring::PinConfig config{};
     config.mode = mode;
+    config.expander = uint8_t(getAsOr<int>(cfg, "expander", 0));
     if (config.mode == wiring::PinMode::PWM) {
         config.pwm.range = 255;
         config.pwm.freq = 1000;
@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "EmergencyStop.hpp"
+#include "Motor.hpp"
+
+namespace motor {
+
+EmergencyStop& EmergencyStop::get() {
+    static EmergencyStop s_stop;
+    return s_stop;
+}
+
+void EmergencyStop::add(Motor* motor) {
+    const std::lock_guard lock(m_mutex);
+    if (m_numMotors == MAX_MOTORS) {
+        throw std::length_error("motor::EmergencyStop::add(): Too many motors");
+    }
+    m_motors[m_numMotors++] = motor;
+}
+
+void EmergencyStop::remove(Motor* motor) {
+    const std::lock_guard lock(m_mutex);
+    const auto end = m_motors.begin() + m_numMotors;
+    const auto it = std::find(m_motors.begin(), end, motor);
+    if (it != end) {
+        *it = m_motors[--m_numMotors];
+    }
+}
+
+void EmergencyStop::trip(Clock::time_point detected) {
+    m_until.store((Clock::now().time_since_epoch() + Clock::duration(m_hold.load(std::memory_order_relaxed))).count(),
+        std::memory_order_relaxed);
+    halt();
+
+    const auto latency = (Clock::now() - detected).count();
+    m_totalLatency.fetch_add(latency, std::memory_order_relaxed);
+    auto max = m_maxLatency.load(std::memory_order_relaxed);
+    while (latency > max && !m_maxLatency.compare_exchange_weak(max, latency, std::memory_order_relaxed)) {}
+    m_trips.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EmergencyStop::enforce() {
+    if (tripped()) {
+        halt();
+    }
+}
+
+void EmergencyStop::halt() {
+    const std::lock_guard lock(m_mutex);
+    for (size_t i = 0; i < m_numMotors; i++) {
+        m_motors[i]->halt();
+    }
+}
+
+Clock::duration EmergencyStop::meanLatency() const {
+    const auto trips = m_trips.load(std::memory_order_relaxed);
+    return Clock::duration(trips == 0 ? 0 : m_totalLatency.load(std::memory_order_relaxed) / Clock::rep(trips));
+}
+
+} // namespace motor
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+#include "utils/Clock.hpp"
+
+namespace motor {
+
+class Motor;
+
+// Stops every motor from whichever thread detects a crash, without waiting for the next tick.
+// Once tripped, the motors are held at 0 until the hold time has passed since the last trip.
+class EmergencyStop {
+public:
+    static constexpr size_t MAX_MOTORS = 16;
+
+    static EmergencyStop& get();
+
+    // Called by Motor::create()'s motors once built and before they are torn down.
+    void add(Motor* motor);
+    void remove(Motor* motor);
+
+    void setHold(Clock::duration hold) { m_hold.store(hold.count(), std::memory_order_relaxed); }
+
+    // Halts every motor straight away. detected is when the cause was measured, for the latency stats.
+    void trip(Clock::time_point detected);
+
+    bool tripped() const { return Clock::now().time_since_epoch().count() < m_until.load(std::memory_order_relaxed); }
+
+    // Halts the motors again if tripped, in case a commit raced with the trip.
+    void enforce();
+
+    size_t trips() const { return m_trips.load(std::memory_order_relaxed); }
+    // From the cause being measured to every motor having been halted.
+    Clock::duration meanLatency() const;
+    Clock::duration maxLatency() const { return Clock::duration(m_maxLatency.load(std::memory_order_relaxed)); }
+
+private:
+    EmergencyStop() = default;
+
+    void halt();
+
+    std::mutex m_mutex;
+    std::array<Motor*, MAX_MOTORS> m_motors = {};
+    size_t m_numMotors = 0;
+
+    std::atomic<Clock::rep> m_hold = std::chrono::nanoseconds(std::chrono::seconds(1)).count();
+    std::atomic<Clock::rep> m_until = 0;
+    std::atomic<size_t> m_trips = 0;
+    std::atomic<Clock::rep> m_totalLatency = 0;
+    std::atomic<Clock::rep> m_maxLatency = 0;
+};
+
+} // namespace motor
@@ -2,9 +2,11 @@
 #include <format>
 #include <map>
 #include <stdexcept>
+#include <utility>
 
 #include "utils/Other.hpp"
 
+#include "EmergencyStop.hpp"
 #include "Motor.hpp"
 
 namespace motor {
@@ -31,6 +33,21 @@ MotorName nameFromString(const std::string_view name) {
     return it->second;
 }
 
+// A motor that the EmergencyStop can halt from its first moment fully built to its last.
+// The most derived class registers, so a trip never calls halt() on a motor being built or torn down.
+template<typename T>
+class Stoppable final : public T {
+public:
+    template<typename... Args>
+    Stoppable(Args&&... args) : T(std::forward<Args>(args)...) {
+        EmergencyStop::get().add(this);
+    }
+
+    ~Stoppable() override {
+        EmergencyStop::get().remove(this);
+    }
+};
+
 Motor::Motor(MotorName name, const wiring::PinConfig& config) :
     m_pin(wiring::Pin::create(config)),
     m_name(name)
@@ -39,6 +56,8 @@ Motor::Motor(MotorName name, const wiring::PinConfig& config) :
 std::unique_ptr<Motor> Motor::create(const boost::json::object& cfg) {
     const auto nameStr = getAsOrThrow<std::string_view>(cfg, "name", "motor::Motor::create()");
     const auto name = nameFromString(nameStr);
+    // The pins are channels of a PCA9685 at this address if it is given.
+    const auto expander = uint8_t(getAsOr<int>(cfg, "expander", 0));
 
     switch (name) {
     case MotorName::FS90R: {
@@ -46,14 +65,16 @@ std::unique_ptr<Motor> Motor::create(const boost::json::object& cfg) {
         wiring::PinConfig config{};
         config.pin = pin;
         config.mode = wiring::PinMode::SERVO;
-        return std::make_unique<Fs90r>(config);
+        config.expander = expander;
+        return std::make_unique<Stoppable<Fs90r>>(config);
     }
     case MotorName::MS18: {
         const auto pin = getAsOrThrow<int>(cfg, "pin", "light::Light::create()");
         wiring::PinConfig config{};
         config.pin = pin;
         config.mode = wiring::PinMode::SERVO;
-        return std::make_unique<Ms18>(config);
+        config.expander = expander;
+        return std::make_unique<Stoppable<Ms18>>(config);
     }
     case MotorName::L298N: {
         const auto pins = getAsVecOrThrow<int>(cfg, "pins", "light::Light::create()");
@@ -64,15 +85,16 @@ std::unique_ptr<Motor> Motor::create(const boost::json::object& cfg) {
         for (size_t i = 0; i < pins.size(); i++) {
             configs[i].pin = pins[i];
             configs[i].mode = wiring::PinMode::PWM;
+            configs[i].expander = expander;
         }
-        return std::make_unique<L298n>(configs[0], configs[1]);
+        return std::make_unique<Stoppable<L298n>>(configs[0], configs[1]);
     }
     default: throw std::logic_error(std::format("Unexpected Motor name: {}", nameStr));
     }
 }
 
 void Fs90r::set(float value) {
-    value = std::clamp(value, -1.0f, 1.0f);
+    value = EmergencyStop::get().tripped() ? 0.0f : std::clamp(value, -1.0f, 1.0f);
     m_value = value;
     value = powf(fabs(value), 2.17391304348f) * sign(value);
     value *= 0.3f;
@@ -81,7 +103,7 @@ void Fs90r::set(float value) {
 
 // TODO: Tune this.
 void Ms18::set(float value) {
-    value = std::clamp(value, -1.0f, 1.0f);
+    value = EmergencyStop::get().tripped() ? 0.0f : std::clamp(value, -1.0f, 1.0f);
     m_value = value;
     m_pin->set(value);
 }
@@ -92,11 +114,16 @@ L298n::L298n(const wiring::PinConfig& fwd, const wiring::PinConfig& bwd) :
 {}
 
 void L298n::set(float value) {
-    value = std::clamp(value, -1.0f, 1.0f);
+    value = EmergencyStop::get().tripped() ? 0.0f : std::clamp(value, -1.0f, 1.0f);
     m_value = value;
     m_pin->set(value);
     m_oPin->set(-value);
 }
 
+void L298n::halt() noexcept {
+    m_pin->halt();
+    m_oPin->halt();
+}
+
 } // namespace light
 
@@ -17,10 +17,18 @@ enum class MotorName : uint8_t {
 
 class Motor {
 public:
+    virtual ~Motor() {}
+
     static std::unique_ptr<Motor> create(const boost::json::object& cfg);
 
     // Sign follows right hand rule when looking at the top of the motor.
+    // Always 0 while the emergency stop is tripped.
     virtual void set(float value) = 0;
+
+    // Stops the motor through the backend from any thread. Used by the EmergencyStop.
+    // Only motors made by create() are registered with it, once they are fully built.
+    virtual void halt() noexcept { m_pin->halt(); }
+
     float get() const { return m_value; }
     MotorName name() const { return m_name; }
 
@@ -51,6 +59,7 @@ public:
     L298n(const wiring::PinConfig& fwd, const wiring::PinConfig& bwd);
 
     void set(float value) override;
+    void halt() noexcept override;
 
 private:
     const std::unique_ptr<wiring::Pin> m_oPin;
@@ -1,6 +1,5 @@
 #include <chrono>
 #include <format>
-#include <map>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
@@ -8,13 +7,20 @@
 #include <string_view>
 #include <thread>
 
+#include "motor/EmergencyStop.hpp"
 #include "pi/Connection.hpp"
 #include "pi/Input.hpp"
 #include "pi/Output.hpp"
+#include "pi/Recording.hpp"
+#include "pi/Registry.hpp"
+#include "utils/Allocation.hpp"
+#include "utils/Clock.hpp"
 #include "utils/Duration.hpp"
 #include "utils/File.hpp"
 #include "utils/JsonHelper.hpp"
 #include "utils/Timer.hpp"
+#include "wiring/Backend.hpp"
+#include "wiring/Bank.hpp"
 
 #include "program/Base.hpp"
 
@@ -24,24 +30,57 @@ using namespace std::literals;
 
 class Prgm : public Base {
 public:
+    ~Prgm() override {
+        const auto& counters = wiring::Bank::get().counters();
+        logger.debug() << std::format("Prgm::~Prgm(): {} output writes, {} dropped, {} input reads, {} backend calls",
+            counters.writes, counters.dropped, counters.reads, counters.calls);
+    }
+
     Prgm(std::string_view nm) : Base(nm) {
         parser.addPositional(path, "path", "The path to the json file.");
+        parser.addOptional(checkAllocations, "check-allocations", "Report every heap allocation made by the loop.");
+        parser.addOptional(recordPath, "record", "Record every input event to a log.");
+        parser.addOptional(replayPath, "replay", "Feed the inputs from a log instead of the hardware.");
+        parser.addOptional(from, "from", "Where to start the replay in the log. The inputs are first fed every event before it.");
+        parser.addOptional(fast, "fast", "Replay as fast as possible instead of in real time.");
+        parser.addOptional(backend, "backend", "The wiring backend: pigpio, gpiochip, gpiochip:<path> for another chip than /dev/gpiochip0, or sim.");
 
         examples.push_back(std::format("{} config.json", prgmName));
+        examples.push_back(std::format("{} config.json --check-allocations", prgmName));
+        examples.push_back(std::format("{} config.json --record drive.log", prgmName));
+        examples.push_back(std::format("{} config.json --replay drive.log --from 30s --fast", prgmName));
+        examples.push_back(std::format("{} config.json --backend sim", prgmName));
+        examples.push_back(std::format("{} config.json --backend gpiochip", prgmName));
+        examples.push_back(std::format("{} config.json --backend gpiochip:/dev/gpiochip4", prgmName));
     }
 
     void init() override {
+        if (!backend.empty()) {
+            wiring::Backend::select(backend);
+        }
+        // The inputs are sampled and the outputs applied together once per tick.
+        wiring::Bank::get().setDeferred(true);
+
         const auto file = readFile(path);
         logger.trace() << "Prgm::init(): File contents:\n" << file;
         json = parse(file);
         const auto& root = getAsObjectOrThrow(json, "Prgm::init()");
         logger.trace() << "Prgm::init(): Config:\n" << root;
 
+        if (!recordPath.empty() && !replayPath.empty()) {
+            throw std::invalid_argument("Prgm::init(): Can not record and replay at the same time");
+        }
+        const bool live = replayPath.empty();
+        if (!live) {
+            // Everything that reads the clock sees the time of the replay.
+            Clock::simulate(Clock::time_point());
+        }
+
         if (auto* v = root.if_contains("inputs")) {
             const auto& inputsCfg = getAsObjectOrThrow(*v, "Prgm::init()");
             for (const auto& [alias, config] : inputsCfg) {
                 const auto& cfg = getAsObjectOrThrow(config, "Prgm::init()");
-                inputs[alias] = pi::Input::create(cfg);
+                registry.addInput(alias, pi::Input::create(cfg, live));
             }
         }
 
@@ -49,7 +88,7 @@ public:
             const auto& outputsCfg = getAsObjectOrThrow(*v, "Prgm::init()");
             for (const auto& [alias, config] : outputsCfg) {
                 const auto& cfg = getAsObjectOrThrow(config, "Prgm::init()");
-                outputs[alias] = pi::Output::create(cfg);
+                registry.addOutput(alias, pi::Output::create(cfg));
             }
         }
 
@@ -57,56 +96,85 @@ public:
             const auto& connectCfg = getAsArrayOrThrow(*v, "Prgm::init()");
             for (const auto& config : connectCfg) {
                 const auto& cfg = getAsObjectOrThrow(config, "Prgm::init()");
-                connections.emplace_back(pi::parseConnection(cfg, inputs, outputs));
+                connections.emplace_back(pi::parseConnection(cfg, registry));
             }
         }
 
-        logger.debug() << "Prgm::init(): Inputs:\n" << [this](){
-            std::stringstream out;
-            for (const auto& [name, input] : inputs) {
-                out << name << ": " << input->type() << '\n';
+        if (!recordPath.empty()) {
+            recorder = std::make_unique<Recorder>(recordPath);
+            registry.record(*recorder);
+        }
+        if (!replayPath.empty()) {
+            player = std::make_unique<Player>(replayPath);
+            registry.replay(*player);
+            if (from.ns() > 0ns) {
+                registry.catchUp(from.ns());
             }
-            return out.str();
-        }();
-        logger.debug() << "Prgm::init(): Outputs:\n" << [this](){
+        }
+
+        if (logger.enabled(LogLevel::DEBUG)) {
             std::stringstream out;
-            for (const auto& [name, output] : outputs) {
-                out << name << ": " << output->type() << '\n';
+            for (Handle i = 0; i < registry.numInputs(); i++) {
+                out << registry.inputName(i) << ": " << registry.input(i).type() << '\n';
+            }
+            logger.debug() << "Prgm::init(): Inputs:\n" << out.str();
+
+            out.str("");
+            for (Handle i = 0; i < registry.numOutputs(); i++) {
+                out << registry.outputName(i) << ": " << registry.output(i).type() << '\n';
             }
-            return out.str();
-        }();
+            logger.debug() << "Prgm::init(): Outputs:\n" << out.str();
+        }
     }
     
     void loop() override {
+        allocation::track(checkAllocations);
         Timer timer(true);
         logger.debug() << "Prgm::loop()";
-        for (const auto& [name, input] : inputs) {
-            input->poll();
-        }
+        wiring::Bank::get().sample();
+        registry.poll();
         for (const auto& connection : connections) {
             connection();
         }
-        for (const auto& [name, output] : outputs) {
-            output->step();
-        }
+        registry.step();
+        wiring::Bank::get().commit();
+        // An emergency stop during the tick could have been overwritten by the commit.
+        motor::EmergencyStop::get().enforce();
         const nanoseconds elapsed = timer.elapsed();
         logger.trace() << "Prgm::loop(): I/O took " << elapsed.count() << "ns";
-        if (elapsed < period.ns()) {
+        if (player != nullptr) {
+            Clock::simulate(Clock::now() + period.ns());
+            running = !player->done();
+        }
+        if (elapsed < period.ns() && !(player != nullptr && fast)) {
             const auto remaining = period.ns() - elapsed;
             logger.trace() << "Prgm::loop(): Sleeping for " << remaining.count() << "ns";
             std::this_thread::sleep_for(remaining);
             logger.trace() << "Prgm::loop(): Slept for " << (timer.elapsed().ns() - elapsed).count() << "ns";
             logger.trace() << "Prgm::loop(): Loop took " << timer.elapsed().ns().count() << "ns";
         }
+        allocation::track(false);
+
+        if (allocation::count() > 0) {
+            allocation::report();
+            allocation::clear();
+        }
     }
 
 private:
     std::string path;
     boost::json::value json;
     Duration period = 10ms;
-    std::map<std::string_view, std::unique_ptr<Input>> inputs;
-    std::vector<std::function<void()>> connections;
-    std::map<std::string_view, std::unique_ptr<Output>> outputs;
+    bool checkAllocations = false;
+    std::string recordPath;
+    std::string replayPath;
+    Duration from;
+    bool fast = false;
+    std::string backend;
+    std::unique_ptr<Recorder> recorder;
+    std::unique_ptr<Player> player;
+    Registry registry;
+    std::vector<Connection> connections;
 };
 
 int main(int argc, char* argv[]) {
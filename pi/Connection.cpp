@@ -12,20 +12,8 @@
 
 namespace pi {
 
-auto split(std::string_view bind) {
-    const auto period = bind.find('.');
-    if (period == std::string_view::npos) {
-        throw std::invalid_argument("Connections must contain at least one period");
-    }
-    return std::make_pair(bind.substr(0, period), bind.substr(period + 1));
-}
-
-Connection parseConnection(
-    const boost::json::object& cfg,
-    const std::map<std::string_view, std::unique_ptr<Input>>& inputs,
-    const std::map<std::string_view, std::unique_ptr<Output>>& outputs)
-{
-    std::vector<std::pair<std::string_view, pi::Producer>> producers;
+Connection parseConnection(const boost::json::object& cfg, Registry& registry) {
+    std::vector<std::pair<std::string_view, Handle>> producers;
     pi::Consumer consumer;
     std::string funcStr;
     for (const auto& [k, v] : cfg) {
@@ -34,12 +22,12 @@ Connection parseConnection(
             funcStr = str;
             continue;
         }
-        const auto [bind, bindKey] = split(str);
         if (k == "output") {
-            consumer = outputs.at(bind)->getConsumer(bindKey);
+            const auto [bind, bindKey] = split(str);
+            consumer = registry.output(registry.outputHandle(bind)).getConsumer(bindKey);
         }
         else {
-            producers.emplace_back(k, inputs.at(bind)->getProducer(bindKey));
+            producers.emplace_back(k, registry.bindSignal(str));
         }
     }
     
@@ -57,11 +45,12 @@ Connection parseConnection(
     // No function case.
     if (funcStr.empty()) {
         return [
-            producer = std::move(producers[0].second),
+            signals = &registry,
+            producer = producers[0].second,
             consumer = std::move(consumer)
             ]
             () {
-                consumer(producer());
+                consumer(signals->signal(producer));
             };
     }
 
@@ -81,37 +70,40 @@ Connection parseConnection(
     if (producers.size() == 1) {
         auto func = script::parse<float>(funcDef.str());
         return [
-            producer = std::move(producers[0].second),
+            signals = &registry,
+            producer = producers[0].second,
             func = std::move(func),
             consumer = std::move(consumer)
             ]
             () {
-                consumer(func(producer()));
+                consumer(func(signals->signal(producer)));
             };
     }
     else if (producers.size() == 2) {
         auto func = script::parse<float,float>(funcDef.str());
         return [
-            x = std::move(producers[0].second),
-            y = std::move(producers[1].second),
+            signals = &registry,
+            x = producers[0].second,
+            y = producers[1].second,
             func = std::move(func),
             consumer = std::move(consumer)
             ]
             () {
-                consumer(func(x(), y()));
+                consumer(func(signals->signal(x), signals->signal(y)));
             };
     }
     else if (producers.size() == 3) {
         auto func = script::parse<float,float,float>(funcDef.str());
         return [
-            x = std::move(producers[0].second),
-            y = std::move(producers[1].second),
-            z = std::move(producers[2].second),
+            signals = &registry,
+            x = producers[0].second,
+            y = producers[1].second,
+            z = producers[2].second,
             func = std::move(func),
             consumer = std::move(consumer)
             ]
             () {
-                consumer(func(x(), y(), z()));
+                consumer(func(signals->signal(x), signals->signal(y), signals->signal(z)));
             };
     }
     else {
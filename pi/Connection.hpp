@@ -1,21 +1,16 @@
 #pragma once
 
-#include <functional>
-#include <map>
-#include <string_view>
-
 #include <boost/json.hpp>
 
-#include "Input.hpp"
-#include "Output.hpp"
+#include "utils/Function.hpp"
+
+#include "Registry.hpp"
 
 namespace pi {
 
-using Connection = std::function<void()>;
+// Big enough for three signals, a script function and a consumer.
+using Connection = Function<void(), 16 * sizeof(void*)>;
 
-Connection parseConnection(
-    const boost::json::object& cfg,
-    const std::map<std::string_view, std::unique_ptr<Input>>& inputs,
-    const std::map<std::string_view, std::unique_ptr<Output>>& outputs);
+Connection parseConnection(const boost::json::object& cfg, Registry& registry);
 
 } // namespace pi
@@ -1,40 +1,153 @@
+#include <bit>
 #include <cstdint>
 #include <format>
 #include <map>
 #include <stdexcept>
 
+#include "adc/Sensor.hpp"
 #include "control/Button.hpp"
 #include "device/Controller.hpp"
+#include "encoder/Sensor.hpp"
+#include "gyro/Sensor.hpp"
+#include "regmap/Sensor.hpp"
+#include "ultrasonic/Sensor.hpp"
 #include "utils/Enum.hpp"
+#include "utils/Fft.hpp"
 #include "utils/JsonHelper.hpp"
 #include "utils/Logger.hpp"
 #include "utils/Other.hpp"
 
 #include "Input.hpp"
+#include "Recording.hpp"
 
 using namespace control;
 using namespace device;
 
 namespace pi {
 
-CREATE_ENUM_SET(InputType, BUTTON, CONTROLLER)
+CREATE_ENUM_SET(InputType, ADC, BUTTON, CONTROLLER, ENCODER, GYRO, REGISTERS, ULTRASONIC)
 
-std::unique_ptr<Input> Input::create(const boost::json::object& cfg) {
+std::unique_ptr<Input> Input::create(const boost::json::object& cfg, bool live) {
     const auto typeStr = getAsOrThrow<std::string_view>(cfg, "type", "pi::Input::create()");
     const auto type = InputTypeFromString(typeStr);
     logger.debug() << "pi::Input::create(): Adding " << typeStr;
     switch (type) {
+    case InputType::ADC: {
+        adc::SensorConfig config;
+        config.address = getAsOr<int>(cfg, "address", config.address);
+        config.channel = getAsOr<int>(cfg, "channel", config.channel);
+        config.rate = getAsOr<int>(cfg, "rate", config.rate);
+        config.readyPin = getAsOr<int>(cfg, "ready", config.readyPin);
+        const auto* channels = cfg.if_contains("channels");
+        if (channels == nullptr) {
+            throw std::invalid_argument("pi::Input::create(): Missing \"channels\" key");
+        }
+        for (const auto& c : getAsArrayOrThrow(*channels, "pi::Input::create()")) {
+            const auto& obj = getAsObjectOrThrow(c, "pi::Input::create(): ADC channel");
+            adc::SensorChannel channel;
+            channel.name = getAsOrThrow<std::string>(obj, "name", "pi::Input::create(): ADC channel");
+            channel.adc.input = adc::adcInputFromString(getAsOr<std::string_view>(obj, "input", "0"));
+            channel.adc.range = getAsOr<float>(obj, "range", channel.adc.range);
+            channel.adc.oversample = getAsOr<int>(obj, "oversample", channel.adc.oversample);
+            channel.scale = getAsOr<float>(obj, "scale", channel.scale);
+            channel.offset = getAsOr<float>(obj, "offset", channel.offset);
+            config.channels.push_back(std::move(channel));
+        }
+        return std::make_unique<adc::Sensor>(config, live);
+    }
     case InputType::BUTTON: {
         const auto pin = getAsOrThrow<int>(cfg, "pin", "pi::Input::create()");
         const auto toggle = getAsOr<bool>(cfg, "toggle", false);
-        return std::make_unique<Button>(pin, toggle);
+        if (getAsOr<bool>(cfg, "edge", false)) {
+            const auto glitch = getAsDurationOr(cfg, "glitch", 5ms);
+            return std::make_unique<Button>(pin, toggle, glitch.ns(), live);
+        }
+        return std::make_unique<Button>(pin, toggle, live);
     }
     case InputType::CONTROLLER: {
         const auto id = getAsOrThrow<std::string_view>(cfg, "id", "pi::Input::create()");
-        return std::make_unique<Controller>(id);
+        return std::make_unique<Controller>(id, live);
+    }
+    case InputType::ENCODER: {
+        encoder::SensorConfig config;
+        config.pinA = getAsOrThrow<int>(cfg, "a", "pi::Input::create()");
+        config.pinB = getAsOrThrow<int>(cfg, "b", "pi::Input::create()");
+        config.glitch = getAsDurationOr(cfg, "glitch", config.glitch).ns();
+        config.estimator = encoder::estimatorFromString(getAsOr<std::string_view>(cfg, "estimator", "auto"));
+        config.threshold = getAsOr<int>(cfg, "threshold", config.threshold);
+        config.scale = getAsOr<float>(cfg, "scale", config.scale);
+        config.timeout = getAsDurationOr(cfg, "timeout", config.timeout).ns();
+        return std::make_unique<encoder::Sensor>(config, live);
+    }
+    case InputType::GYRO: {
+        gyro::SensorConfig config;
+        config.address = getAsOr<int>(cfg, "address", config.address);
+        config.channel = getAsOr<int>(cfg, "channel", config.channel);
+        config.rate = getAsOr<int>(cfg, "rate", config.rate);
+        config.interruptPin = getAsOr<int>(cfg, "interrupt", config.interruptPin);
+        config.filter = gyro::fusionFilterFromString(getAsOr<std::string_view>(cfg, "filter", "madgwick"));
+        const auto defaultGain = config.filter == gyro::FusionFilter::MADGWICK ? gyro::Fusion::MADGWICK_GAIN : gyro::Fusion::COMPLEMENTARY_GAIN;
+        config.gain = getAsOr<float>(cfg, "gain", defaultGain);
+        config.calibration = getAsOr<std::string>(cfg, "calibration", "");
+        config.estimateBias = getAsOr<bool>(cfg, "estimate-bias", config.estimateBias);
+        // Checked here, as a negative size would make the FFT try to allocate most of the address space.
+        const auto window = getAsOr<int>(cfg, "vibration-window", int(config.vibrationWindow));
+        const auto hop = getAsOr<int>(cfg, "vibration-hop", int(config.vibrationHop));
+        if (window < int(RealFft::MIN_SIZE) || !std::has_single_bit(unsigned(window))) {
+            throw std::invalid_argument(std::format("pi::Input::create(): \"vibration-window\" must be a power of two of at least {}: {}",
+                RealFft::MIN_SIZE, window));
+        }
+        if (hop <= 0 || hop > window) {
+            throw std::invalid_argument(std::format("pi::Input::create(): \"vibration-hop\" must be from 1 to the window: {}", hop));
+        }
+        config.vibrationWindow = size_t(window);
+        config.vibrationHop = size_t(hop);
+        const auto bands = getAsVecOr<float>(cfg, "vibration-bands", {});
+        if (bands.size() == 2) {
+            config.vibrationBands = {bands[0], bands[1]};
+        }
+        else if (!bands.empty()) {
+            throw std::invalid_argument("pi::Input::create(): \"vibration-bands\" must be 2 frequencies");
+        }
+        config.impact = getAsOr<bool>(cfg, "impact", config.impact);
+        config.impactThreshold = getAsOr<float>(cfg, "impact-threshold", config.impactThreshold);
+        config.impactJerk = getAsOr<float>(cfg, "impact-jerk", config.impactJerk);
+        config.impactHold = getAsDurationOr(cfg, "impact-hold", config.impactHold).ns();
+        return std::make_unique<gyro::Sensor>(config, live);
+    }
+    case InputType::REGISTERS: {
+        // The device is described inline or in a file of its own, so one description serves every config.
+        const auto* device = cfg.if_contains("device");
+        if (device == nullptr) {
+            throw std::invalid_argument("pi::Input::create(): Missing \"device\" key");
+        }
+        regmap::SensorConfig config;
+        if (device->is_string()) {
+            config.map = regmap::DeviceMap::load(getAsOrThrow<std::string>(*device, "pi::Input::create()"));
+        }
+        else {
+            config.map = regmap::DeviceMap::parse(getAsObjectOrThrow(*device, "pi::Input::create()"));
+        }
+        config.map.address = getAsOr<int>(cfg, "address", config.map.address);
+        config.channel = getAsOr<int>(cfg, "channel", config.channel);
+        config.rate = getAsOr<int>(cfg, "rate", config.rate);
+        return std::make_unique<regmap::Sensor>(config, live);
+    }
+    case InputType::ULTRASONIC: {
+        ultrasonic::SensorConfig config;
+        config.triggerPin = getAsOrThrow<int>(cfg, "trigger", "pi::Input::create()");
+        config.echoPin = getAsOrThrow<int>(cfg, "echo", "pi::Input::create()");
+        config.window = getAsOr<int>(cfg, "window", config.window);
+        return std::make_unique<ultrasonic::Sensor>(config, live);
     }
     default: throw std::invalid_argument(std::format("Unrecognized Input type: {}", typeStr));
     }
 }
 
+void Input::record(std::span<const std::byte> event) const {
+    if (m_recorder != nullptr) {
+        m_recorder->write(m_source, event);
+    }
+}
+
 } // namespace pi
@@ -1,34 +1,75 @@
 #pragma once
 
-#include <functional>
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include <boost/json.hpp>
 
 namespace pi {
 
-using Producer = std::function<float()>;
+using Handle = uint32_t;
+
+class Recorder;
 
 class Input {
 public:
     virtual ~Input() {}
 
-    static std::unique_ptr<Input> create(const boost::json::object& cfg);
+    // Inputs that are not live are only fed by replay() and never touch the hardware.
+    static std::unique_ptr<Input> create(const boost::json::object& cfg, bool live = true);
 
+    // Updates the exported values.
     virtual void poll() = 0;
 
-    virtual Producer getProducer(std::string_view key) const = 0;
+    // Returns the index of the exported value for the key. Throws if the key is not exported.
+    virtual size_t index(std::string_view key) const = 0;
+
+    // Publishes the exported value at index into slot of the signal column on every poll.
+    void bind(size_t index, Handle slot) { m_binds.emplace_back(index, slot); }
+
+    // Writes every bound value into the signal column.
+    void publish(std::span<float> column) const {
+        for (const auto& [index, slot] : m_binds) {
+            column[slot] = m_values[index];
+        }
+    }
+
+    float read(std::string_view key) const { return m_values[index(key)]; }
 
-    virtual float read(std::string_view key) const { return getProducer(key)(); };
+    // Writes the raw events of the input to the recorder under source.
+    void record(Recorder& recorder, uint16_t source) {
+        m_recorder = &recorder;
+        m_source = source;
+    }
+
+    // Applies a recorded event as if it had just been polled.
+    // Inputs that do not record anything have nothing to replay.
+    virtual void replay(std::span<const std::byte> event) {}
 
     std::string_view type() const { return m_type; }
 
 protected:
-    Input(std::string_view type) : m_type(type) {}
+    Input(std::string_view type, size_t numValues) : m_values(numValues, 0.0f), m_type(type) {}
+
+    // Records an event if recording. Called by the subclasses when polled.
+    void record(std::span<const std::byte> event) const;
+
+    template <typename T>
+    void record(const T& event) const { record(std::as_bytes(std::span(&event, 1))); }
+
+    // Written by the subclasses when polled.
+    std::vector<float> m_values;
 
 private:
     std::string m_type;
+    std::vector<std::pair<size_t, Handle>> m_binds;
+    Recorder* m_recorder = nullptr;
+    uint16_t m_source = 0;
 };
 
 } // namespace pi
@@ -5,9 +5,11 @@
 
 #include <boost/json.hpp>
 
+#include "utils/Function.hpp"
+
 namespace pi {
 
-using Consumer = std::function<void(float)>;
+using Consumer = Function<void(float)>;
 
 class Output {
 public:
@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+#include "utils/Logger.hpp"
+
+#include "Recording.hpp"
+
+namespace pi {
+
+constexpr size_t INITIAL_SIZE = 1 << 20;
+
+constexpr size_t padded(size_t size) {
+    return (size + 7) & ~size_t(7);
+}
+
+Recorder::Recorder(const std::string& path) :
+    m_file(path, MappedFile::Mode::WRITE),
+    m_start(Clock::now())
+{
+    m_file.resize(INITIAL_SIZE);
+    auto& head = header();
+    head.magic = LOG_MAGIC;
+    head.version = LOG_VERSION;
+    head.reserved = 0;
+    head.end = sizeof(LogHeader);
+    head.lastIndex = 0;
+    m_blockOffset = head.end;
+}
+
+Recorder::~Recorder() {
+    // Drop the unused space that was reserved for growth.
+    try {
+        m_file.resize(header().end);
+    }
+    catch (const std::exception& e) {
+        logger.error() << "pi::Recorder::~Recorder(): " << e.what();
+    }
+}
+
+uint16_t Recorder::addSource(std::string_view name) {
+    const auto source = m_numSources++;
+    auto* data = append(RecordType::SOURCE, source, 0, name.size());
+    std::memcpy(data, name.data(), name.size());
+    logger.debug() << "pi::Recorder::addSource(): " << name << " -> " << source;
+    return source;
+}
+
+void Recorder::write(uint16_t source, std::span<const std::byte> payload) {
+    const uint64_t time = (Clock::now() - m_start).count();
+    auto* data = append(RecordType::EVENT, source, time, payload.size());
+    std::memcpy(data, payload.data(), payload.size());
+
+    if (m_count == 0) {
+        m_blockTime = time;
+    }
+    if (++m_count < INDEX_INTERVAL) {
+        return;
+    }
+
+    const auto offset = header().end;
+    auto& block = *reinterpret_cast<IndexBlock*>(append(RecordType::INDEX, 0, time, sizeof(IndexBlock)));
+    block = {header().lastIndex, m_blockTime, m_blockOffset, m_count};
+    header().lastIndex = offset;
+    m_blockOffset = header().end;
+    m_count = 0;
+}
+
+std::byte* Recorder::append(RecordType type, uint16_t source, uint64_t time, size_t size) {
+    const auto offset = header().end;
+    const auto end = offset + sizeof(RecordHeader) + padded(size);
+    if (end > m_file.size()) {
+        // Doubling keeps the remaps rare enough to not matter to the loop.
+        m_file.resize(std::max(end, 2 * m_file.size()));
+    }
+
+    auto* data = m_file.data().data() + offset;
+    *reinterpret_cast<RecordHeader*>(data) = {time, source, type, uint32_t(size)};
+    std::memset(data + sizeof(RecordHeader) + size, 0, padded(size) - size);
+    header().end = end;
+    return data + sizeof(RecordHeader);
+}
+
+Player::Player(const std::string& path) : m_file(path, MappedFile::Mode::READ) {
+    if (m_file.size() < sizeof(LogHeader)) {
+        throw std::runtime_error(std::format("pi::Player::Player(): {} is too small to be a log", path));
+    }
+    const auto& head = *reinterpret_cast<const LogHeader*>(m_file.data().data());
+    if (head.magic != LOG_MAGIC) {
+        throw std::runtime_error(std::format("pi::Player::Player(): {} is not a log", path));
+    }
+    if (head.version != LOG_VERSION) {
+        throw std::runtime_error(std::format("pi::Player::Player(): Unsupported log version: {}", head.version));
+    }
+    m_end = std::min<uint64_t>(head.end, m_file.size());
+
+    for (auto offset = m_offset; offset < m_end; offset += sizeof(RecordHeader) + padded(record(offset).size)) {
+        const auto& rec = record(offset);
+        if (rec.type == RecordType::SOURCE) {
+            if (rec.source != m_sources.size()) {
+                throw std::runtime_error(std::format("pi::Player::Player(): Unexpected source id: {}", rec.source));
+            }
+            const auto* name = reinterpret_cast<const char*>(&rec + 1);
+            m_sources.emplace_back(name, rec.size);
+        }
+        else if (rec.type == RecordType::EVENT) {
+            if (rec.source >= m_sources.size()) {
+                throw std::runtime_error(std::format("pi::Player::Player(): Event from unknown source: {}", rec.source));
+            }
+            m_duration = Clock::duration(rec.time);
+        }
+    }
+    logger.debug() << std::format("pi::Player::Player(): {} sources over {} s", m_sources.size(), m_duration.count() * 1e-9);
+
+    start();
+}
+
+const RecordHeader& Player::record(uint64_t offset) const {
+    // The header has to be in the file before its size can be read.
+    if (offset + sizeof(RecordHeader) > m_end) {
+        throw std::runtime_error(std::format("pi::Player: Record header at {} is cut short", offset));
+    }
+    const auto& rec = *reinterpret_cast<const RecordHeader*>(m_file.data().data() + offset);
+    if (rec.size > m_end - offset - sizeof(RecordHeader)) {
+        throw std::runtime_error(std::format("pi::Player: Record at {} is cut short", offset));
+    }
+    return rec;
+}
+
+std::optional<Player::Event> Player::next() {
+    const auto now = Clock::now() - m_start + m_from;
+    while (m_offset < m_end) {
+        const auto& rec = record(m_offset);
+        if (rec.type == RecordType::EVENT && Clock::duration(rec.time) > now) {
+            return std::nullopt;
+        }
+
+        m_offset += sizeof(RecordHeader) + padded(rec.size);
+        if (rec.type == RecordType::EVENT) {
+            return Event{Clock::duration(rec.time), rec.source, {reinterpret_cast<const std::byte*>(&rec + 1), rec.size}};
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<Player::Event> Player::nextBefore(Clock::duration time) {
+    while (m_offset < m_end) {
+        const auto& rec = record(m_offset);
+        if (rec.type == RecordType::EVENT && Clock::duration(rec.time) >= time) {
+            return std::nullopt;
+        }
+
+        m_offset += sizeof(RecordHeader) + padded(rec.size);
+        if (rec.type == RecordType::EVENT) {
+            return Event{Clock::duration(rec.time), rec.source, {reinterpret_cast<const std::byte*>(&rec + 1), rec.size}};
+        }
+    }
+    return std::nullopt;
+}
+
+void Player::seek(Clock::duration time) {
+    // Walk back from the newest index block to the first one that starts before the time.
+    const auto& head = *reinterpret_cast<const LogHeader*>(m_file.data().data());
+    m_offset = sizeof(LogHeader);
+    for (auto offset = head.lastIndex; offset != 0;) {
+        const auto& block = *reinterpret_cast<const IndexBlock*>(&record(offset) + 1);
+        if (Clock::duration(block.firstTime) <= time) {
+            m_offset = block.firstOffset;
+            break;
+        }
+        offset = block.previous;
+    }
+
+    // Then scan forward to the exact event.
+    while (m_offset < m_end) {
+        const auto& rec = record(m_offset);
+        if (rec.type == RecordType::EVENT && Clock::duration(rec.time) >= time) {
+            break;
+        }
+        m_offset += sizeof(RecordHeader) + padded(rec.size);
+    }
+
+    m_from = time;
+    start();
+}
+
+} // namespace pi
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils/Clock.hpp"
+#include "utils/MappedFile.hpp"
+
+namespace pi {
+
+// The log is a header followed by records that are each padded to 8 bytes.
+// Every INDEX_INTERVAL records an index block is appended that points back to the previous one,
+// so a reader can seek by walking the chain from the header instead of scanning every record.
+
+constexpr std::array<char, 8> LOG_MAGIC = {'R', 'A', 'P', 'P', 'Y', 'L', 'O', 'G'};
+constexpr uint32_t LOG_VERSION = 1;
+constexpr size_t INDEX_INTERVAL = 256;
+
+enum class RecordType : uint16_t {
+    SOURCE,
+    EVENT,
+    INDEX
+};
+
+struct LogHeader {
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t reserved;
+    // Where the next record goes. Kept up to date on every write so a log cut short is still readable.
+    uint64_t end;
+    // The offset of the last index block or 0 if there is none.
+    uint64_t lastIndex;
+};
+
+struct RecordHeader {
+    // Nanoseconds since the recording started.
+    uint64_t time;
+    uint16_t source;
+    RecordType type;
+    uint32_t size;
+};
+
+struct IndexBlock {
+    uint64_t previous;
+    uint64_t firstTime;
+    uint64_t firstOffset;
+    uint64_t count;
+};
+
+static_assert(sizeof(LogHeader) % 8 == 0 && sizeof(RecordHeader) % 8 == 0 && sizeof(IndexBlock) % 8 == 0);
+
+// Appends the events of every source to a memory-mapped log.
+class Recorder {
+public:
+    explicit Recorder(const std::string& path);
+    ~Recorder();
+
+    // Adds a named stream and returns the id its events are written under.
+    uint16_t addSource(std::string_view name);
+
+    // Writes an event timestamped with the current time.
+    void write(uint16_t source, std::span<const std::byte> payload);
+
+    template <typename T>
+    void write(uint16_t source, const T& event) { write(source, std::as_bytes(std::span(&event, 1))); }
+
+private:
+    std::byte* append(RecordType type, uint16_t source, uint64_t time, size_t size);
+    LogHeader& header() { return *reinterpret_cast<LogHeader*>(m_file.data().data()); }
+
+    MappedFile m_file;
+    const Clock::time_point m_start;
+    uint16_t m_numSources = 0;
+    size_t m_count = 0;
+    uint64_t m_blockTime = 0;
+    uint64_t m_blockOffset = 0;
+};
+
+// Reads the events back out of a log in the order they were written.
+class Player {
+public:
+    struct Event {
+        Clock::duration time;
+        uint16_t source;
+        std::span<const std::byte> payload;
+    };
+
+    explicit Player(const std::string& path);
+
+    // The source names indexed by id.
+    std::span<const std::string> sources() const { return m_sources; }
+
+    // The time of the last event.
+    Clock::duration duration() const { return m_duration; }
+
+    // Restarts the time the events are played relative to.
+    void start() { m_start = Clock::now(); }
+
+    // Returns the next event that is due by now or nothing if there is none yet.
+    std::optional<Event> next();
+
+    // Returns the next event before time since the start of the log however far ahead of the clock it is,
+    // or nothing once the events reach time.
+    std::optional<Event> nextBefore(Clock::duration time);
+
+    // Skips to the first event at or after time since the start of the log.
+    void seek(Clock::duration time);
+
+    bool done() const { return m_offset >= m_end; }
+
+private:
+    const RecordHeader& record(uint64_t offset) const;
+
+    MappedFile m_file;
+    std::vector<std::string> m_sources;
+    Clock::duration m_duration{};
+    Clock::time_point m_start;
+    // The time the log is played from.
+    Clock::duration m_from{};
+    uint64_t m_offset = sizeof(LogHeader);
+    uint64_t m_end = sizeof(LogHeader);
+};
+
+} // namespace pi
@@ -0,0 +1,131 @@
+#include <format>
+#include <stdexcept>
+
+#include "utils/Logger.hpp"
+
+#include "Registry.hpp"
+
+namespace pi {
+
+std::pair<std::string_view, std::string_view> split(std::string_view bind) {
+    const auto period = bind.find('.');
+    if (period == std::string_view::npos) {
+        throw std::invalid_argument("Connections must contain at least one period");
+    }
+    return std::make_pair(bind.substr(0, period), bind.substr(period + 1));
+}
+
+template <typename Handles>
+Handle Registry::find(const Handles& handles, std::string_view name, std::string_view what) {
+    const auto it = handles.find(name);
+    if (it == handles.end()) {
+        throw std::invalid_argument(std::format("pi::Registry: Unknown {}: {}", what, name));
+    }
+    return it->second;
+}
+
+Handle Registry::addInput(std::string_view name, std::unique_ptr<Input>&& input) {
+    if (m_inputHandles.contains(name)) {
+        throw std::invalid_argument(std::format("pi::Registry::addInput(): Duplicate input: {}", name));
+    }
+    const Handle handle = m_inputs.size();
+    m_inputs.push_back(std::move(input));
+    m_inputNames.emplace_back(name);
+    m_inputHandles.emplace(name, handle);
+    return handle;
+}
+
+Handle Registry::addOutput(std::string_view name, std::unique_ptr<Output>&& output) {
+    if (m_outputHandles.contains(name)) {
+        throw std::invalid_argument(std::format("pi::Registry::addOutput(): Duplicate output: {}", name));
+    }
+    const Handle handle = m_outputs.size();
+    m_outputs.push_back(std::move(output));
+    m_outputNames.emplace_back(name);
+    m_outputHandles.emplace(name, handle);
+    return handle;
+}
+
+Handle Registry::bindSignal(std::string_view bind) {
+    if (const auto it = m_signalHandles.find(bind); it != m_signalHandles.end()) {
+        return it->second;
+    }
+
+    const auto [name, key] = split(bind);
+    auto& in = input(inputHandle(name));
+    const auto index = in.index(key);
+
+    const Handle handle = m_signals.size();
+    in.bind(index, handle);
+    m_signals.push_back(in.read(key));
+    m_signalNames.emplace_back(bind);
+    m_signalHandles.emplace(bind, handle);
+    logger.debug() << "pi::Registry::bindSignal(): " << bind << " -> " << handle;
+    return handle;
+}
+
+Handle Registry::inputHandle(std::string_view name) const {
+    return find(m_inputHandles, name, "input");
+}
+
+Handle Registry::outputHandle(std::string_view name) const {
+    return find(m_outputHandles, name, "output");
+}
+
+Handle Registry::signalHandle(std::string_view bind) const {
+    return find(m_signalHandles, bind, "signal");
+}
+
+void Registry::record(Recorder& recorder) {
+    for (Handle i = 0; i < m_inputs.size(); i++) {
+        m_inputs[i]->record(recorder, recorder.addSource(m_inputNames[i]));
+    }
+}
+
+void Registry::replay(Player& player) {
+    m_player = &player;
+    m_sources.clear();
+    for (const auto& name : player.sources()) {
+        const auto it = m_inputHandles.find(name);
+        if (it == m_inputHandles.end()) {
+            logger.warning() << "pi::Registry::replay(): No input for recorded source: " << name;
+        }
+        m_sources.push_back(it != m_inputHandles.end() ? it->second : NONE);
+    }
+}
+
+void Registry::catchUp(Clock::duration time) {
+    while (const auto event = m_player->nextBefore(time)) {
+        if (const auto handle = m_sources[event->source]; handle != NONE) {
+            m_inputs[handle]->replay(event->payload);
+        }
+    }
+    m_player->seek(time);
+}
+
+void Registry::poll() {
+    if (m_player != nullptr) {
+        while (const auto event = m_player->next()) {
+            if (const auto handle = m_sources[event->source]; handle != NONE) {
+                m_inputs[handle]->replay(event->payload);
+            }
+        }
+        for (const auto& input : m_inputs) {
+            input->publish(m_signals);
+        }
+        return;
+    }
+
+    for (const auto& input : m_inputs) {
+        input->poll();
+        input->publish(m_signals);
+    }
+}
+
+void Registry::step() {
+    for (const auto& output : m_outputs) {
+        output->step();
+    }
+}
+
+} // namespace pi
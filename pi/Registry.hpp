@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Input.hpp"
+#include "Output.hpp"
+#include "Recording.hpp"
+
+namespace pi {
+
+// Splits a "name.key" bind into its name and key.
+std::pair<std::string_view, std::string_view> split(std::string_view bind);
+
+// Owns all of the inputs, outputs and signals of a program.
+// Everything is given a dense handle when it is loaded so that the per-tick path only walks flat arrays.
+// The signals are a single float column that the inputs publish their bound values into once per poll.
+// The name lookups are only meant for loading and tooling.
+class Registry {
+public:
+    Handle addInput(std::string_view name, std::unique_ptr<Input>&& input);
+    Handle addOutput(std::string_view name, std::unique_ptr<Output>&& output);
+
+    // Binds an "input.key" pair to a signal. Binding the same pair twice returns the same signal.
+    Handle bindSignal(std::string_view bind);
+
+    Handle inputHandle(std::string_view name) const;
+    Handle outputHandle(std::string_view name) const;
+    Handle signalHandle(std::string_view bind) const;
+
+    Input& input(Handle handle) const { return *m_inputs[handle]; }
+    Output& output(Handle handle) const { return *m_outputs[handle]; }
+    float signal(Handle handle) const { return m_signals[handle]; }
+    std::span<const float> signals() const { return m_signals; }
+
+    // Copies the whole signal column into out, which must hold numSignals() values.
+    void snapshot(std::span<float> out) const { std::memcpy(out.data(), m_signals.data(), m_signals.size() * sizeof(float)); }
+
+    std::string_view inputName(Handle handle) const { return m_inputNames[handle]; }
+    std::string_view outputName(Handle handle) const { return m_outputNames[handle]; }
+    std::string_view signalName(Handle handle) const { return m_signalNames[handle]; }
+
+    size_t numInputs() const { return m_inputs.size(); }
+    size_t numOutputs() const { return m_outputs.size(); }
+    size_t numSignals() const { return m_signals.size(); }
+
+    // Records the events of every input that has been added so far.
+    void record(Recorder& recorder);
+
+    // Feeds the inputs from the player instead of polling them.
+    // Inputs are matched to the recorded sources by name and sources without an input are skipped.
+    void replay(Player& player);
+
+    // After replay(), feeds the inputs every event before time without publishing anything, so a replay started
+    // part way through begins with the inputs as they were then, like a toggled button or a gyro's fused attitude.
+    // Leaves the player at time.
+    void catchUp(Clock::duration time);
+
+    // Polls every input, or plays every event that is due, and publishes the signals.
+    void poll();
+
+    // Steps every output.
+    void step();
+
+private:
+    static constexpr Handle NONE = std::numeric_limits<Handle>::max();
+
+    template <typename Handles>
+    static Handle find(const Handles& handles, std::string_view name, std::string_view what);
+
+    std::vector<std::unique_ptr<Input>> m_inputs;
+    std::vector<std::unique_ptr<Output>> m_outputs;
+    std::vector<float> m_signals;
+
+    Player* m_player = nullptr;
+    // The input for each recorded source.
+    std::vector<Handle> m_sources;
+
+    std::vector<std::string> m_inputNames;
+    std::vector<std::string> m_outputNames;
+    std::vector<std::string> m_signalNames;
+    std::map<std::string, Handle, std::less<>> m_inputHandles;
+    std::map<std::string, Handle, std::less<>> m_outputHandles;
+    std::map<std::string, Handle, std::less<>> m_signalHandles;
+};
+
+} // namespace pi
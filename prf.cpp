@@ -1,41 +1,741 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
+#include <boost/json.hpp>
+
+#include <time.h>
+
+#include "encoder/Encoder.hpp"
+#include "encoder/Sensor.hpp"
+#include "gyro/Gyrometer.hpp"
+#include "pi/Connection.hpp"
+#include "pi/Input.hpp"
+#include "pi/Output.hpp"
+#include "pi/Registry.hpp"
 #include "script/Parser.hpp"
+#include "ultrasonic/Sensor.hpp"
+#include "utils/Enum.hpp"
 #include "utils/Logger.hpp"
+#include "utils/Statistics.hpp"
 #include "utils/Timer.hpp"
+#include "wiring/Backend.hpp"
+#include "wiring/Bank.hpp"
+#include "wiring/I2cBus.hpp"
+#include "wiring/Pca9685.hpp"
+#include "wiring/Pca9685Model.hpp"
+#include "wiring/Pin.hpp"
+#include "wiring/SimBackend.hpp"
+
+#include "program/Base.hpp"
+
+using namespace program;
+
+CREATE_ENUM_SET(Benchmark, SCRIPT, REGISTRY, CONNECTION, BACKEND, GYRO, STATS, EXPANDER, ENCODER, RANGER)
 
-constexpr int MAX = 1000000;
 constexpr int SIZE = 8;
 
-int main(int argc, char* argv[]) {
-    float data[SIZE];
+// The CPU time used by every thread of the process.
+nanoseconds cpuTime() {
+    timespec time{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    return seconds(time.tv_sec) + nanoseconds(time.tv_nsec);
+}
+
+// Fails the benchmark when a result is wrong, as a fast wrong answer measures nothing.
+void check(bool ok, std::string_view what) {
+    if (!ok) {
+        throw std::runtime_error(std::format("Check failed: {}", what));
+    }
+}
+
+// An I2C address in any base C++ can parse, like "0x68".
+uint8_t parseAddress(const std::string& address) {
+    size_t end = 0;
+    int value = -1;
+    try {
+        value = std::stoi(address, &end, 0);
+    }
+    catch (const std::exception&) {}
+    if (end != address.size() || value < 0 || value > 0x7F) {
+        throw std::invalid_argument(std::format("Not a 7 bit I2C address: {}", address));
+    }
+    return uint8_t(value);
+}
+
+// A fake input that changes every poll.
+class Counter : public pi::Input {
+public:
+    Counter() : pi::Input("Counter", 1) {}
+
+    void poll() override { m_values[0] += 1.0f; }
+
+    size_t index(std::string_view key) const override { return 0; }
+
+    float value() const { return m_values[0]; }
+};
+
+// A fake output that accumulates everything it is given.
+class Sink : public pi::Output {
+public:
+    Sink() : pi::Output("Sink") {}
+
+    pi::Consumer getConsumer(std::string_view key) override { return [this](float value) { set(value); }; }
+
+    void set(float value) { m_value = value; }
+
+    void step() override { m_total += m_value; }
+
+    float total() const { return m_total; }
+
+private:
+    float m_value = 0.0f;
+    float m_total = 0.0f;
+};
+
+class Prgm : public Base {
+public:
+    Prgm(std::string_view nm) : Base(nm) {
+        parser.addPositional(benchmark, "benchmark", "The benchmark to run: script, registry, connection, backend, gyro, stats, expander, encoder or ranger.");
+        parser.addOptional(iterations, "iterations", "The number of iterations to run.");
+        parser.addOptional(devices, "devices", "The number of inputs and outputs for the registry benchmark.");
+        parser.addOptional(arg0, "x", "The first argument to the script function.");
+        parser.addOptional(arg1, "y", "The second argument to the script function.");
+        parser.addOptional(backend, "backend", "The wiring backend for the backend and gyro benchmarks. Runs every backend if not given.");
+        parser.addOptional(outPin, "out", "The output pin for the backend benchmark.");
+        parser.addOptional(inPin, "in", "The input pin for the backend benchmark.");
+        parser.addOptional(address, "address", "The I2C address of the gyro for the gyro benchmark, like 0x68.");
+        parser.addOptional(intPin, "int", "The pin wired to the gyro's INT pin. Also benchmarks interrupt driven reads if given.");
+        parser.addOptional(channels, "channels", "Also streams from a gyro at 0x69 behind each of this many TCA9548A channels at once.");
+
+        examples.push_back(std::format("{} script --x 1.0 --y 2.0", prgmName));
+        examples.push_back(std::format("{} registry --devices 128", prgmName));
+        examples.push_back(std::format("{} connection --iterations 10000000", prgmName));
+        examples.push_back(std::format("{} backend --backend gpiochip --out 4 --in 5", prgmName));
+        examples.push_back(std::format("{} gyro --iterations 2000", prgmName));
+        examples.push_back(std::format("{} gyro --backend sim --int 3", prgmName));
+        examples.push_back(std::format("{} gyro --backend sim --channels 2", prgmName));
+        examples.push_back(std::format("{} gyro --address 0x69", prgmName));
+        examples.push_back(std::format("{} stats --iterations 100", prgmName));
+        examples.push_back(std::format("{} expander --iterations 10000", prgmName));
+        examples.push_back(std::format("{} encoder --iterations 100000", prgmName));
+        examples.push_back(std::format("{} ranger", prgmName));
+    }
+
+    void init() override {
+        switch (BenchmarkFromString(benchmark)) {
+        case Benchmark::SCRIPT:     runScript(); break;
+        case Benchmark::REGISTRY:   runRegistry(); break;
+        case Benchmark::CONNECTION: runConnection(); break;
+        case Benchmark::BACKEND:    runBackends(); break;
+        case Benchmark::GYRO:       runGyro(); break;
+        case Benchmark::STATS:      runStats(); break;
+        case Benchmark::EXPANDER:   runExpander(); break;
+        case Benchmark::ENCODER:    runEncoder(); break;
+        case Benchmark::RANGER:     runRanger(); break;
+        default: throw std::invalid_argument(std::format("Unrecognized benchmark: {}", benchmark));
+        }
+        running = false;
+    }
+
+    void loop() override {}
+
+private:
+    void runScript() {
+        float data[SIZE];
+
+        auto func = script::parse<float,float>("(a,b){a+b}");
+        Timer timer;
+
+        logger.info() << "Running script function";
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            data[i % SIZE] = func(arg0, arg1);
+        }
+        timer.stop();
+        logger.info() << "Script function ran in: " << timer.elapsed().get() << " s";
+
+        logger.info() << "Running raw function";
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            data[i % SIZE] = arg0 + arg1;
+        }
+        timer.stop();
+        logger.info() << "Raw function ran in: " << timer.elapsed().get() << " s";
+        logger.debug() << "Last result: " << data[(iterations - 1) % SIZE];
+    }
+
+    void runRegistry() {
+        std::vector<std::string> inputNames;
+        std::vector<std::string> outputNames;
+        for (int i = 0; i < devices; i++) {
+            inputNames.push_back(std::format("in{}", i));
+            outputNames.push_back(std::format("out{}", i));
+        }
+
+        // The layout that pi used before the registry, with producers reaching into the inputs.
+        std::map<std::string_view, std::unique_ptr<pi::Input>> inputs;
+        std::map<std::string_view, std::unique_ptr<pi::Output>> outputs;
+        std::vector<pi::Connection> mapConnections;
+        for (int i = 0; i < devices; i++) {
+            inputs[inputNames[i]] = std::make_unique<Counter>();
+            outputs[outputNames[i]] = std::make_unique<Sink>();
+        }
+        for (int i = 0; i < devices; i++) {
+            const auto* input = static_cast<const Counter*>(inputs.at(inputNames[i]).get());
+            mapConnections.emplace_back([
+                producer = std::function<float()>([input]() { return input->value(); }),
+                consumer = outputs.at(outputNames[i])->getConsumer("value")
+                ]
+                () {
+                    consumer(producer());
+                });
+        }
+
+        pi::Registry reg;
+        std::vector<pi::Connection> regConnections;
+        for (int i = 0; i < devices; i++) {
+            reg.addInput(inputNames[i], std::make_unique<Counter>());
+            reg.addOutput(outputNames[i], std::make_unique<Sink>());
+        }
+        for (int i = 0; i < devices; i++) {
+            const boost::json::object cfg = {
+                {"input", std::format("{}.value", inputNames[i])},
+                {"output", std::format("{}.value", outputNames[i])}
+            };
+            regConnections.emplace_back(pi::parseConnection(cfg, reg));
+        }
+
+        Timer timer;
+
+        logger.info() << std::format("Running {} ticks with {} inputs and outputs", iterations, devices);
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            for (const auto& [name, input] : inputs) {
+                input->poll();
+            }
+            for (const auto& connection : mapConnections) {
+                connection();
+            }
+            for (const auto& [name, output] : outputs) {
+                output->step();
+            }
+        }
+        timer.stop();
+        const auto mapTime = timer.elapsed().ns().count();
+        logger.info() << "Map tick: " << mapTime / iterations << " ns";
+
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            reg.poll();
+            for (const auto& connection : regConnections) {
+                connection();
+            }
+            reg.step();
+        }
+        timer.stop();
+        const auto regTime = timer.elapsed().ns().count();
+        logger.info() << "Registry tick: " << regTime / iterations << " ns";
+
+        float total = 0.0f;
+        for (const auto& [name, output] : outputs) {
+            total += static_cast<const Sink&>(*output).total();
+        }
+        for (pi::Handle i = 0; i < reg.numOutputs(); i++) {
+            total -= static_cast<const Sink&>(reg.output(i)).total();
+        }
+        logger.debug() << "Difference in totals: " << total;
+    }
+
+    void runConnection() {
+        pi::Registry reg;
+        reg.addInput("x", std::make_unique<Counter>());
+        reg.addInput("y", std::make_unique<Counter>());
+        reg.addOutput("out", std::make_unique<Sink>());
+        reg.poll();
+
+        // How a two input connection was built before: std::function producers feeding
+        // a tree of std::function script nodes and a std::function consumer.
+        const auto* x = static_cast<const Counter*>(&reg.input(reg.inputHandle("x")));
+        const auto* y = static_cast<const Counter*>(&reg.input(reg.inputHandle("y")));
+        std::function<float()> producerX = [x]() { return x->value(); };
+        std::function<float()> producerY = [y]() { return y->value(); };
+        auto a = std::make_shared<float>(0.0f);
+        auto b = std::make_shared<float>(0.0f);
+        std::function<float()> left = [a]() { return *a; };
+        std::function<float()> right = [b]() { return *b; };
+        std::function<float()> body = [left, right]() { return left() + right(); };
+        std::function<float(float, float)> func = [a, b, body](float x, float y) { *a = x; *b = y; return body(); };
+        auto& sink = static_cast<Sink&>(reg.output(0));
+        std::function<void(float)> consumer = [s = &sink](float value) { s->set(value); };
+        const std::function<void()> before = [producerX, producerY, func, consumer]() {
+            consumer(func(producerX(), producerY()));
+        };
+
+        const boost::json::object cfg = {
+            {"a", "x.value"},
+            {"b", "y.value"},
+            {"function", "a + b"},
+            {"output", "out.value"}
+        };
+        const auto after = pi::parseConnection(cfg, reg);
 
-    if (argc != 3) {
-        logger.error() << "Expected two arguments";
-        return 1;
+        Timer timer;
+
+        logger.info() << std::format("Running {} calls of a two input connection", iterations);
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            before();
+            sink.step();
+        }
+        timer.stop();
+        logger.info() << "std::function connection: " << timer.elapsed().get() * 1e9f / iterations << " ns";
+
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            after();
+            sink.step();
+        }
+        timer.stop();
+        logger.info() << "Function connection: " << timer.elapsed().get() * 1e9f / iterations << " ns";
+        logger.debug() << "Total: " << sink.total();
+    }
+
+    void runBackends() {
+        const std::vector<std::string> names = backend.empty() ?
+            std::vector<std::string>{"pigpio", "gpiochip", "sim"} :
+            std::vector<std::string>{backend};
+
+        for (const auto& name : names) {
+            try {
+                wiring::Backend::select(name);
+                runBackend(name);
+            }
+            catch (const std::exception& e) {
+                logger.warning() << std::format("Skipping the {} backend: {}", name, e.what());
+            }
+        }
+    }
+
+    void runBackend(std::string_view name) {
+        auto out = wiring::Pin::create({outPin, wiring::PinMode::OUT});
+        auto in = wiring::Pin::create({inPin, wiring::PinMode::IN});
+        auto& bknd = wiring::Backend::get();
+        const auto inMask = uint64_t(1) << wiring::pinRemap(inPin);
+
+        Timer timer;
+        logger.info() << std::format("{}: Running {} sets, gets and bulk reads", name, iterations);
+
+        auto cpuStart = cpuTime();
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            out->set(float(i & 1));
+        }
+        timer.stop();
+        const auto setCpu = cpuTime() - cpuStart;
+        logger.info() << std::format("{}: set: {} ns, {} ns of CPU",
+            name, timer.elapsed().ns().count() / iterations, setCpu.count() / iterations);
+
+        float total = 0.0f;
+        cpuStart = cpuTime();
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            total += in->get();
+        }
+        timer.stop();
+        const auto getCpu = cpuTime() - cpuStart;
+        logger.info() << std::format("{}: get: {} ns, {} ns of CPU",
+            name, timer.elapsed().ns().count() / iterations, getCpu.count() / iterations);
+
+        uint64_t bits = 0;
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            bits ^= bknd.read(inMask);
+        }
+        timer.stop();
+        logger.info() << std::format("{}: bulk read: {} ns", name, timer.elapsed().ns().count() / iterations);
+
+        // Whatever the backend burns in the background while the program does nothing.
+        cpuStart = cpuTime();
+        timer.start();
+        std::this_thread::sleep_for(1s);
+        timer.stop();
+        const auto idleCpu = cpuTime() - cpuStart;
+        logger.info() << std::format("{}: idle: {:.2f} % of a core", name, 100.0f * idleCpu.count() / timer.elapsed().ns().count());
+        logger.debug() << "Inputs read: " << total << ", " << bits;
+    }
+
+    void runGyro() {
+        if (!backend.empty()) {
+            wiring::Backend::select(backend);
+        }
+        gyro::Gyrometer gyrometer(gyro::GyroRange::DEG_250, gyro::AccelRange::G_2, "", parseAddress(address));
+        Timer timer;
+
+        logger.info() << std::format("Reading every axis {} times", iterations);
+        float total = 0.0f;
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            total += gyrometer.accelX() + gyrometer.accelY() + gyrometer.accelZ();
+            total += gyrometer.rotX() + gyrometer.rotY() + gyrometer.rotZ();
+        }
+        timer.stop();
+        const auto axisTime = timer.elapsed().get();
+        logger.info() << std::format("Per axis reads: {:.0f} samples/s", iterations / axisTime);
+
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            const auto sample = gyrometer.sample();
+            for (size_t a = 0; a < gyro::NUM_AXES; a++) {
+                total += sample.accel[a] + sample.rot[a];
+            }
+        }
+        timer.stop();
+        const auto burstTime = timer.elapsed().get();
+        logger.info() << std::format("Burst reads: {:.0f} samples/s ({:.1f}x)", iterations / burstTime, axisTime / burstTime);
+
+        // Streaming costs the caller no I2C traffic, so this measures the rate the sensor delivers at.
+        const auto stream = [&]() {
+            gyro::RawSample raw;
+            size_t streamed = 0;
+            timer.start();
+            while (timer.elapsed().get() < 1.0f) {
+                while (gyrometer.pop(raw)) {
+                    total += raw.rot[gyro::NUM_AXES - 1];
+                    streamed++;
+                }
+                std::this_thread::sleep_for(1ms);
+            }
+            timer.stop();
+            return streamed / timer.elapsed().get();
+        };
+
+        gyrometer.startStream(1000);
+        const auto fifoRate = stream();
+        logger.info() << std::format("Streaming: {:.0f} samples/s, {} overflows, {} dropped", fifoRate, gyrometer.overflows(), gyrometer.dropped());
+        gyrometer.stopStream();
+
+        if (intPin >= 0) {
+            gyrometer.startInterrupt(intPin, 1000);
+            const auto intRate = stream();
+            logger.info() << std::format("Interrupts: {:.0f} samples/s, {:.1f} us latency, {} dropped",
+                intRate, std::chrono::duration<float, std::micro>(gyrometer.latency()).count(), gyrometer.dropped());
+            gyrometer.stopStream();
+        }
+
+        if (channels > 0) {
+            std::vector<std::unique_ptr<gyro::Gyrometer>> muxed;
+            for (int channel = 0; channel < channels; channel++) {
+                muxed.push_back(std::make_unique<gyro::Gyrometer>(gyro::GyroRange::DEG_250, gyro::AccelRange::G_2, "", gyro::Gyrometer::ALT_ADDRESS, channel));
+            }
+            const auto before = wiring::I2cBus::get()->counters();
+            for (auto& g : muxed) {
+                g->startStream(1000);
+            }
+
+            gyro::RawSample raw;
+            size_t streamed = 0;
+            timer.start();
+            while (timer.elapsed().get() < 1.0f) {
+                for (auto& g : muxed) {
+                    while (g->pop(raw)) {
+                        total += raw.rot[gyro::NUM_AXES - 1];
+                        streamed++;
+                    }
+                }
+                std::this_thread::sleep_for(1ms);
+            }
+            timer.stop();
+            const auto after = wiring::I2cBus::get()->counters();
+            size_t overflows = 0;
+            for (auto& g : muxed) {
+                g->stopStream();
+                overflows += g->overflows();
+            }
+            logger.info() << std::format("Muxed: {:.0f} samples/s from {} gyros, {} overflows, {} mux switches and {} transactions in {} passes",
+                streamed / timer.elapsed().get(), channels, overflows, after.switches - before.switches,
+                after.transactions - before.transactions, after.passes - before.passes);
+        }
+        logger.debug() << "Total: " << total;
+    }
+
+    void runStats() {
+        // A second of samples at 8 kHz, like the self test or a bias estimate would see.
+        constexpr size_t NUM_SAMPLES = 8192;
+        std::vector<std::array<int16_t, 3>> samples(NUM_SAMPLES);
+        uint32_t seed = 1;
+        for (auto& xyz : samples) {
+            for (auto& value : xyz) {
+                seed = seed * 1664525 + 1013904223;
+                value = int16_t(seed >> 16);
+            }
+        }
+        Timer timer;
+
+        logger.info() << std::format("Accumulating {} samples {} times", NUM_SAMPLES, iterations);
+        std::array<RunningStats, 3> scalar;
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            for (const auto& xyz : samples) {
+                for (size_t a = 0; a < 3; a++) {
+                    scalar[a].add(xyz[a]);
+                }
+            }
+        }
+        timer.stop();
+        const auto scalarTime = timer.elapsed().get();
+        logger.info() << std::format("Welford per value: {:.1f} M samples/s", iterations * NUM_SAMPLES / scalarTime / 1e6f);
+
+        std::array<RunningStats, 3> block;
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            addXyz(samples, block);
+        }
+        timer.stop();
+        const auto blockTime = timer.elapsed().get();
+        logger.info() << std::format("Block sums: {:.1f} M samples/s ({:.1f}x)", iterations * NUM_SAMPLES / blockTime / 1e6f, scalarTime / blockTime);
+        logger.debug() << std::format("Means: {} {}, stddevs: {} {}", scalar[0].mean(), block[0].mean(), scalar[0].stddev(), block[0].stddev());
+
+        Histogram histogram(-32768.0f, 32768.0f);
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            histogram.reset();
+            for (const auto& xyz : samples) {
+                histogram.add(xyz[0]);
+            }
+        }
+        timer.stop();
+        logger.info() << std::format("Histogram: {:.1f} M samples/s", iterations * NUM_SAMPLES / timer.elapsed().get() / 1e6f);
+
+        // The samples are uniform, so each percentile is that fraction of the way across the range.
+        for (const auto p : {0.05f, 0.5f, 0.95f}) {
+            const auto expected = -32768.0f + 65536.0f * p;
+            const auto actual = histogram.percentile(p);
+            logger.debug() << std::format("p{:.0f}: {:.0f}, expected {:.0f}", p * 100.0f, actual, expected);
+            check(std::abs(actual - expected) < 0.01f * 65536.0f, std::format("p{:.0f} of uniform samples is {:.0f}", p * 100.0f, actual));
+        }
     }
-    float arg0 = std::stof(std::string(argv[1]));
-    float arg1 = std::stof(std::string(argv[2]));
 
-    auto func = script::parse<float,float>("(a,b){a+b}");
-    Timer timer;
+    // Stages every channel of the sim's PCA9685 and commits them together, which should be one block write.
+    void runExpander() {
+        wiring::Backend::select("sim");
+        auto& sim = dynamic_cast<wiring::SimBackend&>(wiring::Backend::get());
+        const auto& model = dynamic_cast<const wiring::Pca9685Model&>(sim.model(wiring::SimBackend::I2C_BUS, wiring::Pca9685Model::ADDRESS));
+        auto& bank = wiring::Bank::get();
+        bank.setDeferred(true);
+
+        std::vector<std::unique_ptr<wiring::Pin>> pins;
+        for (int channel = 0; channel < wiring::Pca9685::NUM_CHANNELS; channel++) {
+            pins.push_back(wiring::Pin::create({channel, wiring::PinMode::SERVO, false, {}, wiring::Pca9685::ADDRESS}));
+        }
+        bank.commit();
+        const auto chip = wiring::Pca9685::get();
+        const auto bus = wiring::I2cBus::get();
+
+        // Every channel changes on every tick.
+        const auto value = [](int channel, int tick) { return float((channel + tick) % wiring::Pca9685::NUM_CHANNELS) / 8.0f - 1.0f; };
+        const auto stageAll = [&](int tick) {
+            for (size_t channel = 0; channel < pins.size(); channel++) {
+                pins[channel]->set(value(int(channel), tick));
+            }
+        };
 
-    logger.info() << "Running script function";
-    timer.start();
-    for (int i = 0; i < MAX; i++) {
-        data[i % SIZE] = func(arg0, arg1);
+        Timer timer;
+        logger.info() << std::format("Committing {} channels {} times", pins.size(), iterations);
+        timer.start();
+        for (int i = 0; i < iterations; i++) {
+            stageAll(i);
+            bank.commit();
+        }
+        timer.stop();
+        logger.info() << std::format("Commits: {:.2f} us per tick", timer.elapsed().get() * 1e6f / iterations);
+
+        stageAll(iterations);
+        const auto busBefore = bus->counters();
+        const auto chipBefore = chip->counters();
+        const auto writesBefore = model.writes();
+        bank.commit();
+        const auto busAfter = bus->counters();
+        const auto chipAfter = chip->counters();
+
+        check(busAfter.transactions - busBefore.transactions == 1, "One commit is one I2C transaction");
+        check(chipAfter.transactions - chipBefore.transactions == 1 && chipAfter.channels - chipBefore.channels == pins.size(),
+            "One commit is one block of every channel");
+        // A block write only lands on all 16 channels with auto increment on.
+        check(model.writes() - writesBefore == pins.size() * 4, std::format("{} register writes for one block", model.writes() - writesBefore));
+
+        const auto tick = 1e6f / (model.frequency() * wiring::Pca9685::RESOLUTION);
+        for (int channel = 0; channel < wiring::Pca9685::NUM_CHANNELS; channel++) {
+            const auto expected = value(channel, iterations) * 1000.0f + 1500.0f;
+            const auto actual = model.pulseWidth(channel);
+            logger.debug() << std::format("Channel {}: {} ticks, {:.1f} us, expected {:.1f} us", channel, model.ticks(channel), actual, expected);
+            check(std::abs(actual - expected) <= tick, std::format("Channel {} pulses for {:.1f} us instead of {:.1f} us", channel, actual, expected));
+        }
+        logger.info() << std::format("Every channel went out in one transaction at {:.1f} Hz", model.frequency());
+
+        pins.clear();
+        bank.setDeferred(false);
     }
-    timer.stop();
-    logger.info() << "Script function ran in: " << timer.elapsed().get() << " s";
 
-    logger.info() << "Running raw function";
-    timer.start();
-    for (int i = 0; i < MAX; i++) {
-        data[i % SIZE] = arg0 + arg1;
+    // Spins the sim's encoder fast and slow and checks every estimator against it, with the same snapshots for each.
+    void runEncoder() {
+        wiring::Backend::select("sim");
+        auto& model = dynamic_cast<wiring::SimBackend&>(wiring::Backend::get()).encoder();
+        // The sim's encoder is on pins 12 and 13.
+        encoder::Encoder enc(12, 13);
+
+        const std::array estimators = {encoder::Estimator::AUTO, encoder::Estimator::PERIOD, encoder::Estimator::DIFFERENCE};
+        constexpr std::array<std::string_view, 3> names = {"auto", "period", "difference"};
+        std::vector<std::unique_ptr<encoder::Sensor>> sensors;
+        for (const auto estimator : estimators) {
+            encoder::SensorConfig config;
+            config.estimator = estimator;
+            sensors.push_back(std::make_unique<encoder::Sensor>(config, false));
+        }
+        const auto replay = [&](const encoder::Snapshot& snapshot) {
+            for (auto& sensor : sensors) {
+                sensor->replay(std::as_bytes(std::span(&snapshot, 1)));
+            }
+        };
+
+        constexpr int POLLS = 10;
+        Timer timer;
+        struct Run {
+            float speed;
+            Clock::duration interval;
+            // Of each estimator, as a fraction of the speed.
+            std::array<float, estimators.size()> tolerances;
+        };
+        // The slow speed is polled so a few counts go by each time, which AUTO reads with the period.
+        // The period is only good for a rough figure at high speed, where the sim's thread waking late jitters the edges.
+        const std::array<Run, 2> runs = {{{20000.0f, 10ms, {0.05f, 0.5f, 0.05f}}, {50.0f, 100ms, {0.05f, 0.05f, 0.05f}}}};
+        for (const auto& [speed, interval, tolerances] : runs) {
+            model.setSpeed(speed);
+            std::this_thread::sleep_for(200ms);
+
+            // The snapshots race the edges, so this also covers the retries.
+            int64_t total = 0;
+            timer.start();
+            for (int i = 0; i < iterations; i++) {
+                total += enc.snapshot().count;
+            }
+            timer.stop();
+            logger.info() << std::format("{:.0f} counts/s: snapshot: {:.0f} ns", speed, timer.elapsed().get() * 1e9f / iterations);
+            logger.debug() << "Counts: " << total;
+
+            replay(enc.snapshot());
+            const auto start = model.position();
+            std::array<float, estimators.size()> velocities = {};
+            timer.start();
+            for (int i = 0; i < POLLS; i++) {
+                std::this_thread::sleep_for(interval);
+                replay(enc.snapshot());
+                for (size_t e = 0; e < sensors.size(); e++) {
+                    velocities[e] += sensors[e]->read("velocity") / POLLS;
+                }
+            }
+            timer.stop();
+            // What the model actually managed, as it can fall behind its speed.
+            const auto actual = float(model.position() - start) / timer.elapsed().get();
+            for (size_t e = 0; e < sensors.size(); e++) {
+                logger.info() << std::format("{:.0f} counts/s: {}: {:.1f} counts/s, {:.1f} actual", speed, names[e], velocities[e], actual);
+                check(std::abs(velocities[e] - actual) <= tolerances[e] * actual, std::format("{} velocity {:.1f} of {:.1f} counts/s", names[e], velocities[e], actual));
+            }
+        }
+
+        model.setSpeed(0.0f);
+        std::this_thread::sleep_for(100ms);
+        const auto snapshot = enc.snapshot();
+        check(snapshot.count == model.position(), std::format("Counted {} of {} edges", snapshot.count, model.position()));
+        check(snapshot.errors == 0, std::format("{} missed edges", snapshot.errors));
+        logger.info() << std::format("Counted all {} edges", snapshot.count);
     }
-    timer.stop();
-    logger.info() << "Raw function ran in: " << timer.elapsed().get() << " s";
 
-    return 0;
+    // Runs both of the sim's rangers for a few seconds, which takes every ranger's stray echoes along.
+    void runRanger() {
+        wiring::Backend::select("sim");
+        auto& sim = dynamic_cast<wiring::SimBackend&>(wiring::Backend::get());
+
+        // The sim's rangers are on pins 5 and 6, and 10 and 11.
+        const std::array<ultrasonic::SensorConfig, 2> configs = {{{5, 6}, {10, 11}}};
+        std::vector<std::unique_ptr<ultrasonic::Sensor>> sensors;
+        std::vector<const wiring::RangerModel*> models;
+        for (size_t r = 0; r < configs.size(); r++) {
+            sensors.push_back(std::make_unique<ultrasonic::Sensor>(configs[r]));
+            models.push_back(&sim.ranger(wiring::SimBackend::RANGER_PINS[r].first));
+        }
+
+        constexpr int POLLS = 300;
+        // Enough for the median to fill up.
+        constexpr int WARM_UP = 50;
+        // The wall sways at up to 0.4 m/s and the median lags it by a few pings.
+        constexpr float TOLERANCE = 0.1f;
+        // The stray echoes come back off something at least this much closer than the wall.
+        constexpr float STRAY = 0.5f;
+        std::vector<float> maxErrors(sensors.size(), 0.0f);
+        std::vector<size_t> strays(sensors.size(), 0);
+        for (int i = 0; i < POLLS; i++) {
+            std::this_thread::sleep_for(10ms);
+            for (size_t r = 0; r < sensors.size(); r++) {
+                sensors[r]->poll();
+                if (i < WARM_UP) {
+                    continue;
+                }
+                const auto distance = models[r]->distance(Clock::now());
+                maxErrors[r] = std::max(maxErrors[r], std::abs(sensors[r]->read("distance") - distance));
+                if (std::abs(sensors[r]->read("distance.raw") - distance) > STRAY) {
+                    strays[r]++;
+                }
+            }
+        }
+
+        for (size_t r = 0; r < sensors.size(); r++) {
+            const auto rate = sensors[r]->read("rate");
+            logger.info() << std::format("Ranger {}: {:.1f} measurements/s, {} pings, {:.3f} m off at most, {} polls with a stray",
+                r, rate, models[r]->pings(), maxErrors[r], strays[r]);
+            check(rate > 0.0f && models[r]->pings() > 0, std::format("Ranger {} measures", r));
+            check(strays[r] > 0, std::format("Ranger {} heard a stray echo", r));
+            check(maxErrors[r] <= TOLERANCE, std::format("Ranger {} is {:.3f} m off", r, maxErrors[r]));
+        }
+
+        // The scheduler only lets one ranger listen at a time, so the echo pulses never overlap.
+        std::vector<std::pair<Clock::time_point, int>> edges;
+        for (const auto& [trigger, echo] : wiring::SimBackend::RANGER_PINS) {
+            for (const auto& sample : sim.waveform(echo)) {
+                edges.push_back({sample.time, sample.value != 0.0f ? 1 : -1});
+            }
+        }
+        std::ranges::sort(edges);
+        int listening = 0;
+        for (const auto& [time, change] : edges) {
+            listening += change;
+            check(listening <= 1, "The echoes of both rangers overlap");
+        }
+        logger.info() << std::format("{} echo edges without an overlap", edges.size());
+    }
+
+    std::string benchmark;
+    int iterations = 1000000;
+    int devices = 128;
+    float arg0 = 1.0f;
+    float arg1 = 2.0f;
+    std::string backend;
+    int outPin = 4;
+    int inPin = 5;
+    std::string address = std::format("{:#04x}", gyro::Gyrometer::ADDRESS);
+    int intPin = -1;
+    int channels = 0;
+};
+
+int main(int argc, char* argv[]) {
+    return std::make_unique<Prgm>(argv[0])->run(argc, argv);
 }
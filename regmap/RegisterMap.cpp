@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <array>
+#include <format>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+#include "utils/File.hpp"
+#include "utils/JsonHelper.hpp"
+
+#include "RegisterMap.hpp"
+
+namespace regmap {
+
+constexpr size_t MAX_WIDTH = 4;
+constexpr size_t NUM_REGISTERS = 256;
+
+// A number, or a string holding one in any base C++ can parse, like "0x3B".
+static int64_t number(const boost::json::object& obj, std::string_view key, int64_t dflt, std::string_view prefix) {
+    const auto* v = obj.if_contains(key);
+    if (v == nullptr) {
+        return dflt;
+    }
+    if (v->is_string()) {
+        const auto str = getAsOrThrow<std::string>(*v, prefix);
+        try {
+            return std::stoll(str, nullptr, 0);
+        }
+        catch (const std::exception&) {
+            throw std::invalid_argument(std::format("{}: \"{}\" is not a number: {}", prefix, key, str));
+        }
+    }
+    return getAsOrThrow<int64_t>(*v, std::format("{}: \"{}\"", prefix, key));
+}
+
+static int64_t numberOrThrow(const boost::json::object& obj, std::string_view key, std::string_view prefix) {
+    if (obj.if_contains(key) == nullptr) {
+        throw std::invalid_argument(std::format("{}: Missing \"{}\" key", prefix, key));
+    }
+    return number(obj, key, 0, prefix);
+}
+
+static uint8_t checkedRegister(int64_t reg, size_t width, std::string_view prefix) {
+    if (reg < 0 || size_t(reg) + width > NUM_REGISTERS) {
+        throw std::invalid_argument(std::format("{}: Register out of range: {:#04x}", prefix, reg));
+    }
+    return uint8_t(reg);
+}
+
+static uint8_t checkedWidth(int64_t width, std::string_view prefix) {
+    if (width < 1 || size_t(width) > MAX_WIDTH) {
+        throw std::invalid_argument(std::format("{}: Width must be 1-{} bytes: {}", prefix, MAX_WIDTH, width));
+    }
+    return uint8_t(width);
+}
+
+DeviceMap DeviceMap::parse(const boost::json::object& obj) {
+    constexpr std::string_view prefix = "regmap::DeviceMap::parse()";
+
+    DeviceMap map;
+    map.name = getAsOr<std::string>(obj, "name", "");
+    const auto address = numberOrThrow(obj, "address", prefix);
+    if (address < 0 || address > 0x7F) {
+        throw std::invalid_argument(std::format("{}: Not a 7 bit address: {:#04x}", prefix, address));
+    }
+    map.address = uint8_t(address);
+    map.bigEndian = getAsOr<bool>(obj, "big-endian", map.bigEndian);
+    map.autoIncrement = getAsOr<bool>(obj, "auto-increment", map.autoIncrement);
+    map.maxGap = size_t(std::max<int64_t>(number(obj, "max-gap", map.maxGap, prefix), 0));
+
+    if (const auto* init = obj.if_contains("init")) {
+        for (const auto& v : getAsArrayOrThrow(*init, prefix)) {
+            const auto& stepObj = getAsObjectOrThrow(v, prefix);
+            InitStep step;
+            step.width = checkedWidth(number(stepObj, "width", step.width, prefix), prefix);
+            step.reg = checkedRegister(numberOrThrow(stepObj, "register", prefix), step.width, prefix);
+            step.value = uint32_t(numberOrThrow(stepObj, "value", prefix));
+            step.delay = getAsDurationOr(stepObj, "delay", Duration()).ns();
+            map.init.push_back(step);
+        }
+    }
+
+    const auto* fields = obj.if_contains("fields");
+    if (fields == nullptr) {
+        throw std::invalid_argument(std::format("{}: Missing \"fields\" key", prefix));
+    }
+    for (const auto& v : getAsArrayOrThrow(*fields, prefix)) {
+        const auto& fieldObj = getAsObjectOrThrow(v, prefix);
+        Field field;
+        field.name = getAsOrThrow<std::string>(fieldObj, "name", prefix);
+        field.width = checkedWidth(number(fieldObj, "width", field.width, prefix), prefix);
+        field.reg = checkedRegister(numberOrThrow(fieldObj, "register", prefix), field.width, prefix);
+        field.bigEndian = getAsOr<bool>(fieldObj, "big-endian", map.bigEndian);
+        field.isSigned = getAsOr<bool>(fieldObj, "signed", field.isSigned);
+        // Checked before narrowing, so a shift of 256 can't wrap around to 0. Without "bits" the field is the rest.
+        const auto shift = number(fieldObj, "shift", field.shift, prefix);
+        const auto bits = number(fieldObj, "bits", 8 * field.width - shift, prefix);
+        if (shift < 0 || bits < 1 || shift + bits > 8 * field.width) {
+            throw std::invalid_argument(std::format("{}: fields.{}: Shift {} and bits {} do not fit in {} bytes",
+                prefix, field.name, shift, bits, field.width));
+        }
+        field.shift = uint8_t(shift);
+        field.bits = uint8_t(bits);
+        field.scale = getAsOr<float>(fieldObj, "scale", field.scale);
+        field.offset = getAsOr<float>(fieldObj, "offset", field.offset);
+
+        if (std::any_of(map.fields.begin(), map.fields.end(), [&](const Field& f) { return f.name == field.name; })) {
+            throw std::invalid_argument(std::format("{}: Duplicate field: {}", prefix, field.name));
+        }
+        map.fields.push_back(std::move(field));
+    }
+    return map;
+}
+
+DeviceMap DeviceMap::load(const std::string& path) {
+    const auto json = ::parse(readFile(path));
+    return parse(getAsObjectOrThrow(json, std::format("regmap::DeviceMap::load(): {}", path)));
+}
+
+void initialise(const DeviceMap& map, const wiring::I2cDevice& device) {
+    for (const auto& step : map.init) {
+        if (step.width == 1) {
+            device.write<uint8_t>(step.reg, uint8_t(step.value));
+        }
+        else {
+            std::array<uint8_t, MAX_WIDTH> bytes;
+            for (size_t i = 0; i < step.width; i++) {
+                const auto shift = 8 * (map.bigEndian ? step.width - 1 - i : i);
+                bytes[i] = uint8_t(step.value >> shift);
+            }
+            device.write<uint8_t>(step.reg, std::span<const uint8_t>(bytes.data(), step.width));
+        }
+        if (step.delay > Clock::duration::zero()) {
+            std::this_thread::sleep_for(step.delay);
+        }
+    }
+}
+
+ReadPlan::ReadPlan(const DeviceMap& map) {
+    // The bytes each register start has to cover, in register order.
+    std::map<uint8_t, uint8_t> spans;
+    for (const auto& field : map.fields) {
+        auto& width = spans[field.reg];
+        width = std::max(width, field.width);
+    }
+
+    // Runs of registers close enough together become one block, as long as the device reads on through them.
+    for (const auto& [reg, width] : spans) {
+        if (map.autoIncrement && !m_blocks.empty()) {
+            auto& last = m_blocks.back();
+            const auto end = size_t(last.reg) + last.length;
+            const auto newEnd = std::max(end, size_t(reg) + width);
+            if (reg <= end + map.maxGap && newEnd - last.reg <= MAX_BLOCK) {
+                m_bytes += newEnd - end;
+                last.length = uint8_t(newEnd - last.reg);
+                continue;
+            }
+        }
+        m_blocks.push_back({reg, width, uint16_t(m_bytes)});
+        m_bytes += width;
+    }
+
+    for (const auto& field : map.fields) {
+        // The last block starting at or before the field holds it.
+        const auto block = std::prev(std::upper_bound(m_blocks.begin(), m_blocks.end(), field.reg, [](uint8_t reg, const Block& b) {
+            return reg < b.reg;
+        }));
+        const auto bits = field.bits != 0 ? field.bits : 8 * field.width - field.shift;
+        Decoder decoder;
+        decoder.byte = uint16_t(block->offset + field.reg - block->reg);
+        decoder.width = field.width;
+        decoder.bigEndian = field.bigEndian;
+        decoder.shift = field.shift;
+        decoder.mask = bits >= 32 ? 0xFFFFFFFF : (uint32_t(1) << bits) - 1;
+        decoder.sign = field.isSigned ? uint32_t(1) << (bits - 1) : 0;
+        decoder.scale = field.scale;
+        decoder.offset = field.offset;
+        m_decoders.push_back(decoder);
+    }
+}
+
+void ReadPlan::read(const wiring::I2cDevice& device, std::span<uint8_t> buffer) const {
+    if (buffer.size() < m_bytes) {
+        throw std::invalid_argument(std::format("regmap::ReadPlan::read(): The buffer needs {} bytes", m_bytes));
+    }
+    for (const auto& block : m_blocks) {
+        device.read<uint8_t>(block.reg, buffer.subspan(block.offset, block.length));
+    }
+}
+
+void ReadPlan::decode(std::span<const uint8_t> buffer, std::span<float> values) const {
+    for (size_t i = 0; i < m_decoders.size(); i++) {
+        const auto& d = m_decoders[i];
+        const auto* bytes = buffer.data() + d.byte;
+        uint32_t raw = 0;
+        for (size_t b = 0; b < d.width; b++) {
+            raw |= uint32_t(bytes[b]) << (8 * (d.bigEndian ? d.width - 1 - b : b));
+        }
+        raw = (raw >> d.shift) & d.mask;
+        auto value = int64_t(raw);
+        if ((raw & d.sign) != 0) {
+            value -= int64_t(d.sign) << 1;
+        }
+        values[i] = float(value) * d.scale + d.offset;
+    }
+}
+
+} // namespace regmap
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include "utils/Clock.hpp"
+#include "wiring/I2cDevice.hpp"
+
+namespace regmap {
+
+// One value decoded from a device's registers.
+struct Field {
+    std::string name;
+    uint8_t reg = 0;
+    // The bytes it spans, 1 to 4.
+    uint8_t width = 1;
+    bool bigEndian = true;
+    bool isSigned = false;
+    // The field is bits wide after shifting the raw value right by shift, or the rest of it if bits is 0.
+    uint8_t shift = 0;
+    uint8_t bits = 0;
+    // The value is the field * scale + offset.
+    float scale = 1.0f;
+    float offset = 0.0f;
+};
+
+// A register write done when the device is set up, followed by a pause if it needs time to take effect.
+struct InitStep {
+    uint8_t reg = 0;
+    uint32_t value = 0;
+    uint8_t width = 1;
+    Clock::duration delay = {};
+};
+
+// A device described by its registers rather than a class of its own, as loaded from JSON:
+//   {
+//     "name": "MPU-6050", "address": "0x68", "big-endian": true,
+//     "init": [{"register": "0x6B", "value": 0, "delay": "100ms"}],
+//     "fields": [{"name": "accel.x", "register": "0x3B", "width": 2, "signed": true, "scale": 0.000061035}]
+//   }
+// Numbers may be given as strings, so registers can be written in hex.
+// A field's "big-endian" overrides the device's, and "shift" and "bits" pick a bit field out of its bytes.
+// "auto-increment" is false for devices whose reads do not run on into the next register,
+// and "max-gap" is how many unused bytes a read may run through to save a transaction.
+struct DeviceMap {
+    std::string name;
+    uint8_t address = 0;
+    bool bigEndian = true;
+    bool autoIncrement = true;
+    size_t maxGap = 3;
+    std::vector<InitStep> init;
+    std::vector<Field> fields;
+
+    static DeviceMap parse(const boost::json::object& obj);
+    static DeviceMap load(const std::string& path);
+};
+
+// Runs the init steps in order.
+void initialise(const DeviceMap& map, const wiring::I2cDevice& device);
+
+// A DeviceMap compiled into the fewest block reads that cover every field, and a decoder per field
+// with its place in the read buffer, mask, sign bit and scale worked out up front.
+class ReadPlan {
+public:
+    // The most an SMBus block read returns in one transaction.
+    static constexpr size_t MAX_BLOCK = 32;
+
+    explicit ReadPlan(const DeviceMap& map);
+
+    size_t fields() const { return m_decoders.size(); }
+    // The block reads, each one transaction.
+    size_t transactions() const { return m_blocks.size(); }
+    size_t bytes() const { return m_bytes; }
+
+    // Reads every block into buffer, which must hold bytes().
+    void read(const wiring::I2cDevice& device, std::span<uint8_t> buffer) const;
+
+    // Decodes every field from buffer into values, in the order of the DeviceMap.
+    void decode(std::span<const uint8_t> buffer, std::span<float> values) const;
+
+private:
+    struct Block {
+        uint8_t reg;
+        uint8_t length;
+        uint16_t offset;
+    };
+
+    struct Decoder {
+        // The first byte of the field in the buffer.
+        uint16_t byte;
+        uint8_t width;
+        bool bigEndian;
+        uint8_t shift;
+        uint32_t mask;
+        // The sign bit after masking, or 0 if unsigned.
+        uint32_t sign;
+        float scale;
+        float offset;
+    };
+
+    std::vector<Block> m_blocks;
+    std::vector<Decoder> m_decoders;
+    size_t m_bytes = 0;
+};
+
+} // namespace regmap
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+#include "utils/Logger.hpp"
+
+#include "Sensor.hpp"
+
+namespace regmap {
+
+Sensor::Sensor(const SensorConfig& config, bool live) :
+    pi::Input("Registers", config.map.fields.size()),
+    m_map(config.map),
+    m_plan(config.map),
+    m_device(live ? std::make_unique<wiring::I2cDevice>(config.map.address, config.map.bigEndian, config.channel) : nullptr),
+    m_buffer(m_plan.bytes()),
+    m_decoded(m_plan.fields()),
+    m_latest(m_plan.fields())
+{
+    if (config.rate <= 0) {
+        throw std::invalid_argument(std::format("regmap::Sensor::Sensor(): Invalid rate: {}", config.rate));
+    }
+    logger.debug() << std::format("regmap::Sensor::Sensor(): {} reads {} fields in {} transactions of {} bytes",
+        m_map.name, m_plan.fields(), m_plan.transactions(), m_plan.bytes());
+
+    if (m_device != nullptr) {
+        initialise(m_map, *m_device);
+        const auto period = std::chrono::nanoseconds(1'000'000'000LL / config.rate);
+        m_job = m_device->bus().schedule(period, m_device->mux(), m_device->channel(), [this] { sample(); });
+    }
+}
+
+Sensor::~Sensor() {
+    if (m_job) {
+        m_device->bus().unschedule(*m_job);
+    }
+}
+
+void Sensor::sample() {
+    m_plan.read(*m_device, m_buffer);
+    m_plan.decode(m_buffer, m_decoded);
+
+    const std::lock_guard lock(m_mutex);
+    m_latest.swap(m_decoded);
+    m_readings++;
+}
+
+void Sensor::poll() {
+    if (m_device == nullptr) {
+        return;
+    }
+
+    {
+        const std::lock_guard lock(m_mutex);
+        if (m_readings == m_polled) {
+            return;
+        }
+        m_polled = m_readings;
+        std::copy(m_latest.begin(), m_latest.end(), m_values.begin());
+    }
+    record(std::as_bytes(std::span<const float>(m_values)));
+}
+
+void Sensor::replay(std::span<const std::byte> event) {
+    if (event.size() != m_values.size() * sizeof(float)) {
+        throw std::invalid_argument(std::format("regmap::Sensor::replay(): Events must be {} bytes", m_values.size() * sizeof(float)));
+    }
+    std::memcpy(m_values.data(), event.data(), event.size());
+}
+
+size_t Sensor::index(std::string_view key) const {
+    const auto it = std::find_if(m_map.fields.begin(), m_map.fields.end(), [key](const Field& f) { return f.name == key; });
+    if (it == m_map.fields.end()) {
+        throw std::invalid_argument(std::format("regmap::Sensor::index(): Unrecognized key: {}", key));
+    }
+    return size_t(it - m_map.fields.begin());
+}
+
+} // namespace regmap
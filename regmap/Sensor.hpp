@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "pi/Input.hpp"
+#include "wiring/I2cBus.hpp"
+#include "wiring/I2cDevice.hpp"
+
+#include "RegisterMap.hpp"
+
+namespace regmap {
+
+struct SensorConfig {
+    DeviceMap map;
+    // The TCA9548A channel the device is behind, if any.
+    int channel = wiring::I2cBus::NO_CHANNEL;
+    // Reads per second.
+    int rate = 100;
+};
+
+// Any I2C device with a DeviceMap, read on the bus scheduler with its ReadPlan.
+// Exports each field by its name. Every new reading is recorded as it is polled.
+class Sensor : public pi::Input {
+public:
+    Sensor(const SensorConfig& config, bool live = true);
+    virtual ~Sensor() override;
+
+    void poll() override;
+
+    size_t index(std::string_view key) const override;
+
+    // Replays the values of every field.
+    void replay(std::span<const std::byte> event) override;
+
+private:
+    // Runs on the scheduler.
+    void sample();
+
+    const DeviceMap m_map;
+    const ReadPlan m_plan;
+    // Null when not live.
+    std::unique_ptr<wiring::I2cDevice> m_device;
+    std::optional<wiring::I2cBus::JobId> m_job;
+
+    // Only touched by the scheduler.
+    std::vector<uint8_t> m_buffer;
+    std::vector<float> m_decoded;
+
+    std::mutex m_mutex;
+    std::vector<float> m_latest;
+    size_t m_readings = 0;
+    size_t m_polled = 0;
+};
+
+} // namespace regmap
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <format>
-#include <functional>
 #include <memory>
 #include <regex>
 #include <string>
@@ -10,12 +9,14 @@
 
 #include "utils/Other.hpp"
 
+#include "Program.hpp"
+
 namespace script {
 
 class ASTNode {
 public:
     virtual ~ASTNode() = default;
-    virtual std::function<float()> get() const = 0;
+    virtual void compile(Program& program) const = 0;
 };
 
 class NumberNode : public ASTNode {
@@ -26,8 +27,8 @@ public:
         return std::regex_match(str.begin(), str.begin() + 1, std::regex("[+-.0-9]"));
     }
 
-    std::function<float()> get() const override {
-        return [value = m_value]() { return value; };
+    void compile(Program& program) const override {
+        program.number(m_value);
     }
 
 private:
@@ -36,22 +37,21 @@ private:
 
 class ArgumentNode : public ASTNode {
 public:
-    ArgumentNode(std::string_view arg) : m_name(arg), m_ptr(std::make_shared<float>(0.0f)) {}
+    ArgumentNode(std::string_view arg, size_t index) : m_name(arg), m_index(index) {}
 
     static bool match(std::string_view str) {
         return std::regex_match(str.begin(), str.begin() + 1, std::regex("[a-zA-Z]"));
     }
 
-    std::function<float()> get() const override {
-        return [arg = m_ptr]() { return *arg; };
+    void compile(Program& program) const override {
+        program.argument(m_index);
     }
 
     std::string_view name() const { return m_name; }
-    std::shared_ptr<float> ptr() const { return m_ptr; }
 
 private:
     const std::string m_name;
-    std::shared_ptr<float> m_ptr;
+    const size_t m_index;
 };
 
 class BinaryOpNode : public ASTNode {
@@ -75,17 +75,10 @@ public:
         }
     }
 
-    std::function<float()> get() const override {
-        std::function<float()> left = m_left->get();
-        std::function<float()> right = m_right->get();
-        switch (m_op) {
-        case '+': return [left = std::move(left), right = std::move(right)]() { return left() + right(); }; break;
-        case '-': return [left = std::move(left), right = std::move(right)]() { return left() - right(); }; break;
-        case '*': return [left = std::move(left), right = std::move(right)]() { return left() * right(); }; break;
-        case '/': return [left = std::move(left), right = std::move(right)]() { return left() / right(); }; break;
-        case '^': return [left = std::move(left), right = std::move(right)]() { return std::pow(left(), right()); }; break;
-        default: throw std::invalid_argument(std::format("Invalid operator: {}", m_op));
-        }
+    void compile(Program& program) const override {
+        m_left->compile(program);
+        m_right->compile(program);
+        program.operation(m_op);
     }
 
 private:
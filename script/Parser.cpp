@@ -104,7 +104,7 @@ std::vector<std::shared_ptr<ArgumentNode>> parseArguments(std::string_view args,
     const auto argsEnd = svregex_iterator();
     for (auto arg = svregex_iterator(args.begin(), args.end(), argRegex); arg != argsEnd; ++arg) {
         const auto& subMatch = (*arg)[0];
-        arguments.emplace_back(std::make_shared<ArgumentNode>(std::string_view(subMatch.first, subMatch.second)));
+        arguments.emplace_back(std::make_shared<ArgumentNode>(std::string_view(subMatch.first, subMatch.second), arguments.size()));
     }
 
     if (arguments.size() != expected) {
@@ -129,63 +129,13 @@ std::pair<std::string_view, std::string_view> parseFunction(std::string& script)
     return { args, expr };
 }
 
-template<>
-std::function<float()> parse(std::string script) {
+Program compile(std::string script, size_t numArgs) {
     auto [args, expr] = parseFunction(script);
-    auto arguments = parseArguments(args, 0);
+    auto arguments = parseArguments(args, numArgs);
     auto node = parseExpression(expr, arguments);
-    return node->get();
-}
-
-template<>
-std::function<float(float)> parse(std::string script) {
-    auto [args, expr] = parseFunction(script);
-    auto arguments = parseArguments(args, 1);
-    auto node = parseExpression(expr, arguments);
-    return [
-        arg0 = arguments[0]->ptr(),
-        func = node->get()
-    ]
-    (float x) {
-        *arg0 = x;
-        return func();
-    };
-}
-
-template<>
-std::function<float(float, float)> parse(std::string script) {
-    auto [args, expr] = parseFunction(script);
-    auto arguments = parseArguments(args, 2);
-    auto node = parseExpression(expr, arguments);
-    return [
-        arg0 = arguments[0]->ptr(),
-        arg1 = arguments[1]->ptr(),
-        func = node->get()
-    ]
-    (float x, float y) {
-        *arg0 = x;
-        *arg1 = y;
-        return func();
-    };
-}
-
-template<>
-std::function<float(float, float, float)> parse(std::string script) {
-    auto [args, expr] = parseFunction(script);
-    auto arguments = parseArguments(args, 3);
-    auto node = parseExpression(expr, arguments);
-    return [
-        arg0 = arguments[0]->ptr(),
-        arg1 = arguments[1]->ptr(),
-        arg2 = arguments[2]->ptr(),
-        func = node->get()
-    ]
-    (float x, float y, float z) {
-        *arg0 = x;
-        *arg1 = y;
-        *arg2 = z;
-        return func();
-    };
+    Program program;
+    node->compile(program);
+    return program;
 }
 
 } // namespace script
@@ -1,11 +1,16 @@
 #pragma once
 
-#include <functional>
-#include <string_view>
+#include <string>
+
+#include "Program.hpp"
 
 namespace script {
 
+Program compile(std::string script, size_t numArgs);
+
 template<class... Args>
-std::function<float(Args...)> parse(std::string script);
+Function<Args...> parse(std::string script) {
+    return Function<Args...>(compile(std::move(script), sizeof...(Args)));
+}
 
 } // namespace script
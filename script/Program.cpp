@@ -0,0 +1,77 @@
+#include <cmath>
+#include <format>
+#include <stdexcept>
+
+#include "Program.hpp"
+
+namespace script {
+
+inline float apply(OpCode code, float left, float right) {
+    switch (code) {
+    case OpCode::ADD:      return left + right;
+    case OpCode::SUBTRACT: return left - right;
+    case OpCode::MULTIPLY: return left * right;
+    case OpCode::DIVIDE:   return left / right;
+    case OpCode::POWER:    return std::pow(left, right);
+    default: throw std::logic_error("script::apply(): Not an operation");
+    }
+}
+
+void Program::number(float value) {
+    if (++m_depth > MAX_DEPTH) {
+        throw std::invalid_argument(std::format("Parse error: Script is nested deeper than {}", MAX_DEPTH));
+    }
+    m_ops.push_back({OpCode::NUMBER, 0, value});
+}
+
+void Program::argument(size_t index) {
+    if (++m_depth > MAX_DEPTH) {
+        throw std::invalid_argument(std::format("Parse error: Script is nested deeper than {}", MAX_DEPTH));
+    }
+    m_ops.push_back({OpCode::ARGUMENT, uint8_t(index)});
+}
+
+void Program::operation(char op) {
+    OpCode code;
+    switch (op) {
+    case '+': code = OpCode::ADD;      break;
+    case '-': code = OpCode::SUBTRACT; break;
+    case '*': code = OpCode::MULTIPLY; break;
+    case '/': code = OpCode::DIVIDE;   break;
+    case '^': code = OpCode::POWER;    break;
+    default: throw std::invalid_argument(std::format("Invalid operator: {}", op));
+    }
+    if (m_depth < 2) {
+        throw std::logic_error("Program::operation(): Not enough operands");
+    }
+    m_depth--;
+
+    // Fold constant operations.
+    const auto size = m_ops.size();
+    if (m_ops[size - 2].code == OpCode::NUMBER && m_ops[size - 1].code == OpCode::NUMBER) {
+        const float right = m_ops.back().value;
+        m_ops.pop_back();
+        m_ops.back().value = apply(code, m_ops.back().value, right);
+        return;
+    }
+
+    m_ops.push_back({code});
+}
+
+float Program::run(std::span<const float> args) const {
+    float stack[MAX_DEPTH];
+    size_t top = 0;
+    for (const auto& op : m_ops) {
+        switch (op.code) {
+        case OpCode::NUMBER:   stack[top++] = op.value; break;
+        case OpCode::ARGUMENT: stack[top++] = args[op.index]; break;
+        default:
+            top--;
+            stack[top - 1] = apply(op.code, stack[top - 1], stack[top]);
+            break;
+        }
+    }
+    return stack[0];
+}
+
+} // namespace script
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace script {
+
+enum class OpCode : uint8_t {
+    NUMBER,
+    ARGUMENT,
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,
+    POWER
+};
+
+struct Op {
+    OpCode code;
+    uint8_t index = 0;
+    float value = 0.0f;
+};
+
+// A compiled expression that is evaluated on a fixed sized stack.
+// Compiling allocates, running never does.
+class Program {
+public:
+    static constexpr size_t MAX_DEPTH = 32;
+
+    void number(float value);
+    void argument(size_t index);
+    void operation(char op);
+
+    float run(std::span<const float> args) const;
+
+    size_t size() const { return m_ops.size(); }
+
+private:
+    std::vector<Op> m_ops;
+    size_t m_depth = 0;
+};
+
+// A parsed script function.
+template <class... Args>
+class Function {
+public:
+    explicit Function(Program&& program) : m_program(std::move(program)) {}
+
+    float operator()(Args... args) const {
+        const float values[] = { float(args)..., 0.0f };
+        return m_program.run(std::span<const float>(values, sizeof...(Args)));
+    }
+
+private:
+    Program m_program;
+};
+
+} // namespace script
@@ -0,0 +1,152 @@
+#include <algorithm>
+
+#include "utils/Logger.hpp"
+
+#include "Ranger.hpp"
+
+namespace ultrasonic {
+
+std::mutex Scheduler::s_mutex;
+std::weak_ptr<Scheduler> Scheduler::s_scheduler;
+
+std::shared_ptr<Scheduler> Scheduler::get() {
+    const std::lock_guard lock(s_mutex);
+    auto scheduler = s_scheduler.lock();
+    if (scheduler == nullptr) {
+        scheduler = std::shared_ptr<Scheduler>(new Scheduler());
+        s_scheduler = scheduler;
+    }
+    return scheduler;
+}
+
+Scheduler::~Scheduler() {
+    {
+        const std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void Scheduler::add(Ranger* ranger) {
+    {
+        const std::lock_guard lock(m_mutex);
+        m_rangers.push_back(ranger);
+        if (!m_thread.joinable()) {
+            m_thread = std::thread(&Scheduler::run, this);
+        }
+    }
+    m_wake.notify_all();
+}
+
+void Scheduler::remove(Ranger* ranger) {
+    // The thread forgets the ranger once it has the lock back, except while pinging it, which it does without the lock.
+    std::unique_lock lock(m_mutex);
+    m_wake.wait(lock, [this, ranger] { return !m_pinging || m_current != ranger; });
+    std::erase(m_rangers, ranger);
+    if (m_current == ranger) {
+        m_current = nullptr;
+    }
+}
+
+void Scheduler::notify() {
+    // Taking the lock makes sure the thread is either waiting or yet to check, so the wake up is not lost.
+    { const std::lock_guard lock(m_mutex); }
+    m_wake.notify_all();
+}
+
+void Scheduler::run() {
+    std::unique_lock lock(m_mutex);
+    while (!m_stop) {
+        if (m_rangers.empty()) {
+            m_wake.wait(lock);
+            continue;
+        }
+
+        m_next %= m_rangers.size();
+        auto* ranger = m_rangers[m_next++];
+        m_current = ranger;
+        // The trigger goes through the backend, which may call the echo alerts with its own locks held.
+        m_pinging = true;
+        lock.unlock();
+        try {
+            ranger->ping();
+        }
+        catch (const std::exception& e) {
+            logger.warning() << "ultrasonic::Scheduler::run(): Ping failed: " << e.what();
+        }
+        lock.lock();
+        m_pinging = false;
+        m_wake.notify_all();
+
+        m_wake.wait_for(lock, ECHO_TIMEOUT, [this] { return m_stop || m_current == nullptr || m_current->heard(); });
+        if (m_current != nullptr) {
+            m_current->finish();
+            m_current = nullptr;
+        }
+
+        m_wake.wait_for(lock, QUIET, [this] { return m_stop; });
+    }
+}
+
+Ranger::Ranger(int triggerPin, int echoPin) :
+    m_scheduler(Scheduler::get()),
+    m_trigger(wiring::PinConfig{triggerPin, wiring::PinMode::OUT}),
+    m_echo(wiring::PinConfig{echoPin, wiring::PinMode::IN})
+{
+    m_echo.setAlert([this](int, bool level, Clock::time_point time) {
+        echo(level, time);
+    });
+    m_scheduler->add(this);
+}
+
+Ranger::~Ranger() {
+    m_scheduler->remove(this);
+    m_echo.setAlert(nullptr);
+}
+
+void Ranger::ping() {
+    m_rise.store(0, std::memory_order_relaxed);
+    m_fall.store(0, std::memory_order_relaxed);
+    m_listening.store(true, std::memory_order_release);
+    m_pinged = Clock::now();
+    m_trigger.pulse(TRIGGER_PULSE);
+}
+
+void Ranger::echo(bool level, Clock::time_point time) {
+    if (!m_listening.load(std::memory_order_acquire)) {
+        return;
+    }
+    const auto ns = time.time_since_epoch().count();
+    if (level) {
+        m_rise.store(ns, std::memory_order_relaxed);
+    }
+    else if (m_rise.load(std::memory_order_relaxed) != 0) {
+        m_fall.store(ns, std::memory_order_release);
+        m_scheduler->notify();
+    }
+}
+
+void Ranger::finish() {
+    m_listening.store(false, std::memory_order_relaxed);
+    const auto fall = m_fall.load(std::memory_order_acquire);
+    const auto rise = m_rise.load(std::memory_order_relaxed);
+
+    Measurement measurement = {m_pinged, MAX_RANGE, false};
+    if (fall != 0 && fall > rise) {
+        // The pulse lasts as long as the sound took to get there and back.
+        const auto width = std::chrono::duration<float>(Clock::duration(fall - rise)).count();
+        const auto distance = width * SPEED_OF_SOUND / 2.0f;
+        if (distance <= MAX_RANGE) {
+            measurement.distance = distance;
+            measurement.echoed = true;
+        }
+    }
+    if (!m_queue.push(measurement)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace ultrasonic
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "utils/Clock.hpp"
+#include "utils/SpscQueue.hpp"
+#include "wiring/Pin.hpp"
+
+namespace ultrasonic {
+
+struct Measurement {
+    Clock::time_point time;
+    // In m, MAX_RANGE when nothing echoed back.
+    float distance;
+    bool echoed;
+};
+
+class Ranger;
+
+// Pings every ranger in turn from one thread, so only one is ever listening and none hears another's echo.
+// The next ping waits for the last echo to end or time out, then for the air to go quiet.
+class Scheduler {
+public:
+    // Echoes take at most 38 ms, which is the HC-SR04's pulse when nothing is in range.
+    static constexpr auto ECHO_TIMEOUT = std::chrono::milliseconds(40);
+    // Left between pings for echoes off things further away than the last one measured to die down.
+    static constexpr auto QUIET = std::chrono::milliseconds(10);
+
+    // The scheduler shared by every ranger while any exist.
+    static std::shared_ptr<Scheduler> get();
+
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    void add(Ranger* ranger);
+    // Waits for the ranger's ping to finish if it is listening.
+    void remove(Ranger* ranger);
+
+    // Wakes the thread when an echo ends.
+    void notify();
+
+private:
+    Scheduler() = default;
+
+    void run();
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<Ranger*> m_rangers;
+    size_t m_next = 0;
+    // The ranger listening for its echo, if any, and whether it is being pinged.
+    Ranger* m_current = nullptr;
+    bool m_pinging = false;
+    bool m_stop = false;
+    std::thread m_thread;
+
+    static std::mutex s_mutex;
+    static std::weak_ptr<Scheduler> s_scheduler;
+};
+
+// An HC-SR04 ultrasonic ranger, pinged by the Scheduler.
+// The echo is timed from the timestamps of the echo pin's edges, so nothing waits on it and the timing is as good as
+// the backend's alerts, which is 5 us with pigpio. Measurements are queued for the consumer.
+class Ranger {
+public:
+    static constexpr float SPEED_OF_SOUND = 343.0f;
+    static constexpr float MAX_RANGE = 4.0f;
+    static constexpr auto TRIGGER_PULSE = std::chrono::microseconds(10);
+
+    Ranger(int triggerPin, int echoPin);
+    ~Ranger();
+
+    Ranger(const Ranger&) = delete;
+    Ranger& operator=(const Ranger&) = delete;
+
+    // Pops the oldest measurement. Returns false if there are none.
+    bool pop(Measurement& measurement) { return m_queue.pop(measurement); }
+
+    // Measurements lost to a full queue.
+    size_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    friend class Scheduler;
+
+    // Called by the scheduler.
+    void ping();
+    bool heard() const { return m_fall.load(std::memory_order_acquire) != 0; }
+    void finish();
+
+    // Called by the backend on every edge of the echo pin.
+    void echo(bool level, Clock::time_point time);
+
+    const std::shared_ptr<Scheduler> m_scheduler;
+    wiring::OutputPin m_trigger;
+    wiring::InputPin m_echo;
+
+    Clock::time_point m_pinged;
+    std::atomic<bool> m_listening = false;
+    // The edges of the echo pulse in ns, 0 until they happen.
+    std::atomic<Clock::rep> m_rise = 0;
+    std::atomic<Clock::rep> m_fall = 0;
+
+    SpscQueue<Measurement, 64> m_queue;
+    std::atomic<size_t> m_dropped = 0;
+};
+
+} // namespace ultrasonic
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+#include "utils/Logger.hpp"
+
+#include "Sensor.hpp"
+
+namespace ultrasonic {
+
+enum SensorValue : size_t {
+    DISTANCE,
+    DISTANCE_RAW,
+    RATE,
+    NUM_VALUES
+};
+
+// The rate is counted over windows this long.
+constexpr auto RATE_WINDOW = std::chrono::seconds(1);
+
+Sensor::Sensor(const SensorConfig& config, bool live) :
+    pi::Input("Ultrasonic", NUM_VALUES),
+    m_ranger(live ? std::make_unique<Ranger>(config.triggerPin, config.echoPin) : nullptr),
+    m_windowSize(config.window)
+{
+    if (config.window == 0) {
+        throw std::invalid_argument("ultrasonic::Sensor::Sensor(): The window must hold at least 1 measurement");
+    }
+    m_window.reserve(m_windowSize);
+    m_sorted.reserve(m_windowSize);
+}
+
+void Sensor::poll() {
+    if (m_ranger == nullptr) {
+        return;
+    }
+
+    Measurement measurement;
+    while (m_ranger->pop(measurement)) {
+        record(measurement);
+        update(measurement);
+    }
+
+    const auto dropped = m_ranger->dropped();
+    if (dropped != m_dropped) {
+        logger.warning() << std::format("ultrasonic::Sensor::poll(): Dropped {} measurements", dropped - m_dropped);
+        m_dropped = dropped;
+    }
+}
+
+void Sensor::replay(std::span<const std::byte> event) {
+    if (event.size() != sizeof(Measurement)) {
+        throw std::invalid_argument(std::format("ultrasonic::Sensor::replay(): Events must be {} bytes", sizeof(Measurement)));
+    }
+    Measurement measurement;
+    std::memcpy(&measurement, event.data(), sizeof(Measurement));
+    update(measurement);
+}
+
+void Sensor::update(const Measurement& measurement) {
+    if (m_window.size() < m_windowSize) {
+        m_window.push_back(measurement.distance);
+    }
+    else {
+        m_window[m_next] = measurement.distance;
+        m_next = (m_next + 1) % m_window.size();
+    }
+
+    m_sorted.assign(m_window.begin(), m_window.end());
+    const auto middle = m_sorted.begin() + m_sorted.size() / 2;
+    std::nth_element(m_sorted.begin(), middle, m_sorted.end());
+    m_values[DISTANCE] = *middle;
+    m_values[DISTANCE_RAW] = measurement.distance;
+
+    if (m_rateCount == 0) {
+        m_rateStart = measurement.time;
+    }
+    m_rateCount++;
+    const auto elapsed = measurement.time - m_rateStart;
+    if (elapsed >= RATE_WINDOW) {
+        // The first measurement only starts the window.
+        m_values[RATE] = float(m_rateCount - 1) / std::chrono::duration<float>(elapsed).count();
+        m_rateStart = measurement.time;
+        m_rateCount = 1;
+    }
+}
+
+size_t Sensor::index(std::string_view key) const {
+    if (key == "distance")     return DISTANCE;
+    if (key == "distance.raw") return DISTANCE_RAW;
+    if (key == "rate")         return RATE;
+    throw std::invalid_argument(std::format("ultrasonic::Sensor::index(): Unrecognized key: {}", key));
+}
+
+} // namespace ultrasonic
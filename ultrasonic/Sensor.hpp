@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "pi/Input.hpp"
+
+#include "Ranger.hpp"
+
+namespace ultrasonic {
+
+struct SensorConfig {
+    int triggerPin = -1;
+    int echoPin = -1;
+    // The filtered distance is the median of this many measurements.
+    size_t window = 5;
+};
+
+// Exports "distance" in m as the median of the last few measurements, which drops lone stray echoes,
+// "distance.raw" as the last measurement and "rate" as the measurements per second the ranger gets.
+// Rangers share one Scheduler, so each one's rate drops as more are added.
+// Every measurement is recorded as it is polled.
+class Sensor : public pi::Input {
+public:
+    Sensor(const SensorConfig& config, bool live = true);
+
+    void poll() override;
+
+    size_t index(std::string_view key) const override;
+
+    // Replays one Measurement.
+    void replay(std::span<const std::byte> event) override;
+
+private:
+    void update(const Measurement& measurement);
+
+    // Null when not live.
+    std::unique_ptr<Ranger> m_ranger;
+    const size_t m_windowSize;
+    // The last measurements, oldest at m_next once full, and a copy to find the median in.
+    std::vector<float> m_window;
+    std::vector<float> m_sorted;
+    size_t m_next = 0;
+    size_t m_dropped = 0;
+
+    Clock::time_point m_rateStart;
+    size_t m_rateCount = 0;
+};
+
+} // namespace ultrasonic
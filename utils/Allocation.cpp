@@ -0,0 +1,146 @@
+#include <cstdlib>
+#include <format>
+#include <new>
+
+#include <execinfo.h>
+
+#include "Logger.hpp"
+
+#include "Allocation.hpp"
+
+namespace allocation {
+
+static thread_local bool s_tracking = false;
+static thread_local bool s_recording = false;
+static thread_local size_t s_count = 0;
+static thread_local size_t s_numSites = 0;
+static thread_local Site s_sites[MAX_SITES];
+
+void record(size_t size) {
+    if (!s_tracking || s_recording) {
+        return;
+    }
+
+    // The backtrace could allocate, so don't record it.
+    s_recording = true;
+    if (s_numSites < MAX_SITES) {
+        auto& site = s_sites[s_numSites++];
+        site.size = size;
+        site.numFrames = backtrace(site.frames, MAX_FRAMES);
+    }
+    s_count++;
+    s_recording = false;
+}
+
+void track(bool enable) {
+    if (enable) {
+        // The first backtrace loads the unwinder, which allocates.
+        void* frame;
+        backtrace(&frame, 1);
+    }
+    s_tracking = enable;
+}
+
+size_t count() {
+    return s_count;
+}
+
+std::span<const Site> sites() {
+    return std::span<const Site>(s_sites, s_numSites);
+}
+
+void clear() {
+    s_count = 0;
+    s_numSites = 0;
+}
+
+void report() {
+    const bool tracking = s_tracking;
+    s_tracking = false;
+
+    logger.error() << std::format("{} heap allocation{} while tracking", s_count, plural(s_count));
+    for (const auto& site : sites()) {
+        logger.error() << std::format("Allocated {} bytes at:", site.size);
+        char** symbols = backtrace_symbols(site.frames, site.numFrames);
+        // Skip the frames inside operator new.
+        for (size_t i = 2; i < site.numFrames; i++) {
+            logger.error() << "    " << (symbols ? symbols[i] : "??");
+        }
+        std::free(symbols);
+    }
+
+    s_tracking = tracking;
+}
+
+} // namespace allocation
+
+// aligned_alloc wants the size to be a multiple of the alignment.
+static void* alignedMalloc(std::size_t size, std::align_val_t alignment) {
+    const auto align = static_cast<std::size_t>(alignment);
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+void* operator new(std::size_t size) {
+    allocation::record(size);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    allocation::record(size);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    allocation::record(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    allocation::record(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    allocation::record(size);
+    if (void* ptr = alignedMalloc(size == 0 ? 1 : size, alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    allocation::record(size);
+    if (void* ptr = alignedMalloc(size == 0 ? 1 : size, alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    allocation::record(size);
+    return alignedMalloc(size == 0 ? 1 : size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    allocation::record(size);
+    return alignedMalloc(size == 0 ? 1 : size, alignment);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
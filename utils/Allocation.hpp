@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+// Tracks heap allocations made on the calling thread.
+// Global operator new is replaced so that the hot loop can prove that it never allocates.
+namespace allocation {
+
+static constexpr size_t MAX_FRAMES = 16;
+static constexpr size_t MAX_SITES = 16;
+
+struct Site {
+    size_t size;
+    size_t numFrames;
+    void* frames[MAX_FRAMES];
+};
+
+// Starts or stops recording the allocations made on this thread.
+void track(bool enable);
+
+// The number of allocations made while tracking since the last clear.
+size_t count();
+
+// The call sites of the first MAX_SITES allocations since the last clear.
+std::span<const Site> sites();
+
+void clear();
+
+// Logs every recorded call site with its backtrace.
+void report();
+
+} // namespace allocation
@@ -0,0 +1,3 @@
+#include "Clock.hpp"
+
+std::atomic<Clock::rep> Clock::s_simulated = REAL;
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// The monotonic clock that all of the timing uses.
+// It can be switched to a simulated time so that replays are deterministic.
+class Clock {
+public:
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<Clock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() {
+        const auto simulated = s_simulated.load(std::memory_order_relaxed);
+        if (simulated != REAL) {
+            return time_point(duration(simulated));
+        }
+        return time_point(std::chrono::steady_clock::now().time_since_epoch());
+    }
+
+    // Freezes the clock at time until it is set again.
+    static void simulate(time_point time) { s_simulated = time.time_since_epoch().count(); }
+
+    // Goes back to the real time.
+    static void real() { s_simulated = REAL; }
+
+    static bool simulated() { return s_simulated != REAL; }
+
+private:
+    static constexpr rep REAL = -1;
+
+    static std::atomic<rep> s_simulated;
+};
@@ -0,0 +1,124 @@
+#include <bit>
+#include <cmath>
+#include <format>
+#include <numbers>
+#include <stdexcept>
+
+#include "Fft.hpp"
+
+RealFft::Buffer RealFft::allocate(size_t size) {
+    return Buffer(new (ALIGNMENT) float[size]());
+}
+
+RealFft::RealFft(size_t size) :
+    m_size(size),
+    m_half(size / 2)
+{
+    if (size < MIN_SIZE || !std::has_single_bit(size)) {
+        throw std::invalid_argument(std::format("RealFft::RealFft(): Size is not a power of two of at least {}: {}", MIN_SIZE, size));
+    }
+
+    constexpr auto TAU = 2.0 * std::numbers::pi;
+    m_re = allocate(m_half);
+    m_im = allocate(m_half);
+
+    // The radix 4 first pass has no twiddles, so the tables start at the stage of length 8.
+    m_twiddleRe = allocate(m_half);
+    m_twiddleIm = allocate(m_half);
+    for (size_t half = 4; half < m_half; half *= 2) {
+        for (size_t j = 0; j < half; j++) {
+            m_twiddleRe[half + j] = float(std::cos(-TAU * j / (2 * half)));
+            m_twiddleIm[half + j] = float(std::sin(-TAU * j / (2 * half)));
+        }
+    }
+
+    m_splitRe = allocate(m_half);
+    m_splitIm = allocate(m_half);
+    for (size_t k = 0; k < m_half; k++) {
+        m_splitRe[k] = float(std::cos(-TAU * k / m_size));
+        m_splitIm[k] = float(std::sin(-TAU * k / m_size));
+    }
+
+    const auto bits = std::countr_zero(m_half);
+    m_reversed = std::make_unique<uint32_t[]>(m_half);
+    for (uint32_t i = 0; i < m_half; i++) {
+        uint32_t reversed = 0;
+        for (int b = 0; b < bits; b++) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_reversed[i] = reversed;
+    }
+}
+
+void RealFft::transform() {
+    auto* __restrict re = m_re.get();
+    auto* __restrict im = m_im.get();
+
+    for (size_t i = 0; i < m_half; i++) {
+        const auto j = m_reversed[i];
+        if (i < j) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+
+    // The first two radix 2 stages as one radix 4 pass, whose only twiddle is -i.
+    for (size_t i = 0; i < m_half; i += 4) {
+        const auto r0 = re[i] + re[i + 1], i0 = im[i] + im[i + 1];
+        const auto r1 = re[i] - re[i + 1], i1 = im[i] - im[i + 1];
+        const auto r2 = re[i + 2] + re[i + 3], i2 = im[i + 2] + im[i + 3];
+        const auto r3 = re[i + 2] - re[i + 3], i3 = im[i + 2] - im[i + 3];
+        re[i] = r0 + r2;     im[i] = i0 + i2;
+        re[i + 2] = r0 - r2; im[i + 2] = i0 - i2;
+        re[i + 1] = r1 + i3; im[i + 1] = i1 - r3;
+        re[i + 3] = r1 - i3; im[i + 3] = i1 + r3;
+    }
+
+    const auto* __restrict twRe = m_twiddleRe.get();
+    const auto* __restrict twIm = m_twiddleIm.get();
+    for (size_t half = 4; half < m_half; half *= 2) {
+        for (size_t start = 0; start < m_half; start += 2 * half) {
+            auto* __restrict aRe = re + start;
+            auto* __restrict aIm = im + start;
+            auto* __restrict bRe = aRe + half;
+            auto* __restrict bIm = aIm + half;
+            for (size_t j = 0; j < half; j++) {
+                const auto wRe = twRe[half + j];
+                const auto wIm = twIm[half + j];
+                const auto tRe = bRe[j] * wRe - bIm[j] * wIm;
+                const auto tIm = bRe[j] * wIm + bIm[j] * wRe;
+                bRe[j] = aRe[j] - tRe;
+                bIm[j] = aIm[j] - tIm;
+                aRe[j] += tRe;
+                aIm[j] += tIm;
+            }
+        }
+    }
+}
+
+void RealFft::power(std::span<const float> input, std::span<float> output) {
+    if (input.size() != m_size || output.size() != numBins()) {
+        throw std::invalid_argument(std::format("RealFft::power(): Expected {} values and {} bins", m_size, numBins()));
+    }
+
+    // Pack the even values as the real parts and the odd ones as the imaginary parts of a half size transform.
+    for (size_t i = 0; i < m_half; i++) {
+        m_re[i] = input[2 * i];
+        m_im[i] = input[2 * i + 1];
+    }
+    transform();
+
+    // Then untangle the spectra of the even and odd values and combine them.
+    output[0] = (m_re[0] + m_im[0]) * (m_re[0] + m_im[0]);
+    output[m_half] = (m_re[0] - m_im[0]) * (m_re[0] - m_im[0]);
+    for (size_t k = 1; k < m_half; k++) {
+        const auto zRe = m_re[k], zIm = m_im[k];
+        const auto cRe = m_re[m_half - k], cIm = -m_im[m_half - k];
+        const auto evenRe = 0.5f * (zRe + cRe), evenIm = 0.5f * (zIm + cIm);
+        // (z - conj) / 2i
+        const auto oddRe = 0.5f * (zIm - cIm), oddIm = -0.5f * (zRe - cRe);
+        const auto re = evenRe + m_splitRe[k] * oddRe - m_splitIm[k] * oddIm;
+        const auto im = evenIm + m_splitRe[k] * oddIm + m_splitIm[k] * oddRe;
+        output[k] = re * re + im * im;
+    }
+}
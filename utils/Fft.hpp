@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+
+// The FFT of a fixed number of real values, which must be a power of two of at least MIN_SIZE.
+// Every buffer and table is allocated once and aligned to cache lines, so transforms never allocate.
+// The complex half size transform keeps the real and imaginary parts in separate arrays, so the butterflies vectorize.
+class RealFft {
+public:
+    static constexpr size_t MIN_SIZE = 8;
+
+    explicit RealFft(size_t size);
+
+    size_t size() const { return m_size; }
+    size_t numBins() const { return m_size / 2 + 1; }
+
+    // Writes the squared magnitude of each of the numBins() bins from 0 Hz to the Nyquist frequency.
+    void power(std::span<const float> input, std::span<float> output);
+
+private:
+    static constexpr std::align_val_t ALIGNMENT{64};
+
+    struct AlignedDelete {
+        void operator()(float* data) const { ::operator delete[](data, ALIGNMENT); }
+    };
+    using Buffer = std::unique_ptr<float[], AlignedDelete>;
+
+    static Buffer allocate(size_t size);
+
+    // The in place transform of the half size complex values in m_re and m_im.
+    void transform();
+
+    const size_t m_size;
+    const size_t m_half;
+    Buffer m_re;
+    Buffer m_im;
+    // The twiddles of each radix 2 stage one after another, so each stage reads them in order.
+    Buffer m_twiddleRe;
+    Buffer m_twiddleIm;
+    // The twiddles that split the half size transform into the real one.
+    Buffer m_splitRe;
+    Buffer m_splitIm;
+    std::unique_ptr<uint32_t[]> m_reversed;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature, size_t Capacity = 4 * sizeof(void*)>
+class Function;
+
+// A copyable callable that is always stored inline, so it never allocates.
+// Callables that do not fit in the capacity are a compile error instead of a hidden heap allocation.
+template <typename R, typename... Args, size_t Capacity>
+class Function<R(Args...), Capacity> {
+public:
+    Function() noexcept = default;
+    Function(std::nullptr_t) noexcept {}
+
+    template <typename F>
+        requires (!std::is_same_v<std::decay_t<F>, Function> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+    Function(F&& func) {
+        using T = std::decay_t<F>;
+        static_assert(sizeof(T) <= Capacity, "Callable does not fit in the Function");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Callable is over aligned for the Function");
+        static_assert(std::is_copy_constructible_v<T>, "Callable must be copyable");
+        new (m_storage) T(std::forward<F>(func));
+        m_ops = &OPS<T>;
+    }
+
+    Function(const Function& other) : m_ops(other.m_ops) {
+        if (m_ops) m_ops->copy(m_storage, other.m_storage);
+    }
+
+    Function(Function&& other) noexcept : m_ops(other.m_ops) {
+        if (m_ops) m_ops->move(m_storage, other.m_storage);
+    }
+
+    ~Function() { reset(); }
+
+    Function& operator=(const Function& other) {
+        if (this != &other) {
+            reset();
+            m_ops = other.m_ops;
+            if (m_ops) m_ops->copy(m_storage, other.m_storage);
+        }
+        return *this;
+    }
+
+    Function& operator=(Function&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_ops = other.m_ops;
+            if (m_ops) m_ops->move(m_storage, other.m_storage);
+        }
+        return *this;
+    }
+
+    R operator()(Args... args) const { return m_ops->call(m_storage, std::forward<Args>(args)...); }
+
+    explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+private:
+    struct Ops {
+        R (*call)(void* storage, Args&&... args);
+        void (*copy)(void* storage, const void* other);
+        void (*move)(void* storage, void* other);
+        void (*destroy)(void* storage);
+    };
+
+    template <typename T>
+    static constexpr Ops OPS = {
+        [](void* storage, Args&&... args) -> R { return (*static_cast<T*>(storage))(std::forward<Args>(args)...); },
+        [](void* storage, const void* other) { new (storage) T(*static_cast<const T*>(other)); },
+        [](void* storage, void* other) { new (storage) T(std::move(*static_cast<T*>(other))); },
+        [](void* storage) { static_cast<T*>(storage)->~T(); }
+    };
+
+    void reset() noexcept {
+        if (m_ops) {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) mutable std::byte m_storage[Capacity];
+    const Ops* m_ops = nullptr;
+};
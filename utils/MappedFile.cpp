@@ -0,0 +1,72 @@
+#include <cerrno>
+#include <format>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MappedFile.hpp"
+
+MappedFile::MappedFile(const std::string& path, Mode mode) : m_mode(mode) {
+    m_fd = mode == Mode::WRITE ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(path.c_str(), O_RDONLY);
+    if (m_fd < 0) {
+        throw std::system_error(errno, std::generic_category(), std::format("open {}", path));
+    }
+
+    struct stat info{};
+    if (fstat(m_fd, &info) < 0) {
+        const auto error = errno;
+        close(m_fd);
+        throw std::system_error(error, std::generic_category(), "fstat");
+    }
+
+    m_size = info.st_size;
+    if (m_size > 0) {
+        const auto prot = m_mode == Mode::WRITE ? PROT_READ | PROT_WRITE : PROT_READ;
+        void* data = mmap(nullptr, m_size, prot, MAP_SHARED, m_fd, 0);
+        if (data == MAP_FAILED) {
+            const auto error = errno;
+            close(m_fd);
+            throw std::system_error(error, std::generic_category(), "mmap");
+        }
+        m_data = static_cast<std::byte*>(data);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (m_data != nullptr) {
+        munmap(m_data, m_size);
+    }
+    close(m_fd);
+}
+
+void MappedFile::resize(size_t size) {
+    if (m_mode != Mode::WRITE) {
+        throw std::logic_error("MappedFile::resize(): File is read only");
+    }
+    if (ftruncate(m_fd, size) < 0) {
+        throw std::system_error(errno, std::generic_category(), "ftruncate");
+    }
+
+    void* data = nullptr;
+    if (m_data == nullptr) {
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    }
+    else if (size == 0) {
+        munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+        return;
+    }
+    else {
+        data = mremap(m_data, m_size, size, MREMAP_MAYMOVE);
+    }
+    if (data == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "mremap");
+    }
+
+    m_data = static_cast<std::byte*>(data);
+    m_size = size;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+// A file that is memory mapped in its entirety.
+// Writable files can be resized, which remaps them without touching the heap.
+class MappedFile {
+public:
+    enum class Mode : uint8_t {
+        READ,
+        WRITE
+    };
+
+    MappedFile(const std::string& path, Mode mode);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::span<std::byte> data() { return {m_data, m_size}; }
+    std::span<const std::byte> data() const { return {m_data, m_size}; }
+    size_t size() const { return m_size; }
+
+    void resize(size_t size);
+
+private:
+    const Mode m_mode;
+    int m_fd = -1;
+    std::byte* m_data = nullptr;
+    size_t m_size = 0;
+};
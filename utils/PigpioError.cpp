@@ -1,3 +1,5 @@
+#ifdef RAPPY_PIGPIO
+
 #include <stdexcept>
 #include <pigpio.h>
 
@@ -167,3 +169,4 @@ int checkError(int code) {
 
 } // namespace pigpio
 
+#endif
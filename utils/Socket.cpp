@@ -89,3 +89,20 @@ std::vector<char> Socket::read(int waitFor) const {
     return buffer;
 }
 
+size_t Socket::read(std::span<char> buffer, int waitFor) const {
+    size_t totalSize = 0;
+
+    while (totalSize < buffer.size() && checkFor(m_fd, IoType::IN, waitFor)) {
+        const auto bytesRead = ::read(m_fd, buffer.data() + totalSize, buffer.size() - totalSize);
+        if (bytesRead < 0) {
+            throw std::system_error(errno, std::generic_category(), "read");
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+
+        totalSize += bytesRead;
+    }
+
+    return totalSize;
+}
@@ -22,6 +22,10 @@ public:
     // waitFor is in ms.
     [[nodiscard]] std::vector<char> read(int waitFor = NO_BLOCK) const;
 
+    // Reads until the buffer is full or nothing is left, without allocating.
+    // Returns the number of bytes read. waitFor is in ms.
+    [[nodiscard]] size_t read(std::span<char> buffer, int waitFor = NO_BLOCK) const;
+
     operator int() const { return fd(); }
 
 private:
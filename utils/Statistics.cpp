@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+#include "Statistics.hpp"
+
+static_assert(sizeof(std::array<int16_t, 3>) == 3 * sizeof(int16_t), "xyz samples must be packed");
+
+void RunningStats::add(double value) {
+    m_count++;
+    const auto delta = value - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * (value - m_mean);
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+}
+
+void RunningStats::merge(const RunningStats& other) {
+    if (other.m_count == 0) {
+        return;
+    }
+    const auto count = m_count + other.m_count;
+    const auto delta = other.m_mean - m_mean;
+    m_m2 += other.m_m2 + delta * delta * (double(m_count) * other.m_count / count);
+    m_mean += delta * other.m_count / count;
+    m_count = count;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+}
+
+double RunningStats::stddev() const {
+    return std::sqrt(variance());
+}
+
+Histogram::Histogram(float min, float max) :
+    m_min(min),
+    m_width((max - min) / NUM_BINS)
+{
+    if (!(max > min)) {
+        throw std::invalid_argument(std::format("Histogram::Histogram(): Empty range [{}, {}]", min, max));
+    }
+}
+
+void Histogram::add(float value) {
+    const auto bin = std::clamp((value - m_min) / m_width, 0.0f, float(NUM_BINS - 1));
+    m_bins[size_t(bin)]++;
+    m_count++;
+}
+
+void Histogram::reset() {
+    m_bins = {};
+    m_count = 0;
+}
+
+float Histogram::percentile(float p) const {
+    if (m_count == 0) {
+        return m_min;
+    }
+    const auto target = std::clamp(p, 0.0f, 1.0f) * m_count;
+    float below = 0.0f;
+    for (size_t i = 0; i < NUM_BINS; i++) {
+        if (m_bins[i] > 0 && below + m_bins[i] >= target) {
+            return m_min + m_width * (i + (target - below) / m_bins[i]);
+        }
+        below += m_bins[i];
+    }
+    return m_min + m_width * NUM_BINS;
+}
+
+namespace {
+
+// Exact sums of a block of one axis, which are merged into the running stats once per block.
+struct BlockSums {
+    int64_t sum = 0;
+    int64_t sumSquares = 0;
+    int16_t min = std::numeric_limits<int16_t>::max();
+    int16_t max = std::numeric_limits<int16_t>::min();
+};
+
+void sumScalar(const std::array<int16_t, 3>* samples, size_t count, std::array<BlockSums, 3>& sums) {
+    for (size_t a = 0; a < 3; a++) {
+        auto& s = sums[a];
+        for (size_t i = 0; i < count; i++) {
+            const int32_t value = samples[i][a];
+            s.sum += value;
+            s.sumSquares += value * value;
+            s.min = std::min<int16_t>(s.min, value);
+            s.max = std::max<int16_t>(s.max, value);
+        }
+    }
+}
+
+#ifdef __ARM_NEON
+// Each 32 bit lane gains at most 2 * 2^15 per step, so the sums are widened before they could overflow.
+constexpr size_t NEON_BLOCK = 16384;
+
+// Only uses what 32 bit ARMv7 NEON has too, so the lanes are added up through pairwise widening adds and stores.
+int64_t addLanes(int64x2_t v) {
+    return vgetq_lane_s64(v, 0) + vgetq_lane_s64(v, 1);
+}
+
+int16_t minLane(int16x8_t v) {
+    std::array<int16_t, 8> lanes;
+    vst1q_s16(lanes.data(), v);
+    return *std::min_element(lanes.begin(), lanes.end());
+}
+
+int16_t maxLane(int16x8_t v) {
+    std::array<int16_t, 8> lanes;
+    vst1q_s16(lanes.data(), v);
+    return *std::max_element(lanes.begin(), lanes.end());
+}
+
+// Deinterleaves 8 samples at a time into one register per axis.
+size_t sumNeon(const std::array<int16_t, 3>* samples, size_t count, std::array<BlockSums, 3>& sums) {
+    size_t i = 0;
+    while (count - i >= 8) {
+        const auto steps = std::min((count - i) / 8, NEON_BLOCK);
+        std::array<int32x4_t, 3> sum32;
+        std::array<int64x2_t, 3> squares;
+        std::array<int16x8_t, 3> mins;
+        std::array<int16x8_t, 3> maxs;
+        for (size_t a = 0; a < 3; a++) {
+            sum32[a] = vdupq_n_s32(0);
+            squares[a] = vdupq_n_s64(0);
+            mins[a] = vdupq_n_s16(std::numeric_limits<int16_t>::max());
+            maxs[a] = vdupq_n_s16(std::numeric_limits<int16_t>::min());
+        }
+
+        for (size_t step = 0; step < steps; step++, i += 8) {
+            const auto xyz = vld3q_s16(samples[i].data());
+            for (size_t a = 0; a < 3; a++) {
+                const auto v = xyz.val[a];
+                sum32[a] = vpadalq_s16(sum32[a], v);
+                squares[a] = vpadalq_s32(squares[a], vmull_s16(vget_low_s16(v), vget_low_s16(v)));
+                squares[a] = vpadalq_s32(squares[a], vmull_s16(vget_high_s16(v), vget_high_s16(v)));
+                mins[a] = vminq_s16(mins[a], v);
+                maxs[a] = vmaxq_s16(maxs[a], v);
+            }
+        }
+
+        for (size_t a = 0; a < 3; a++) {
+            sums[a].sum += addLanes(vpaddlq_s32(sum32[a]));
+            sums[a].sumSquares += addLanes(squares[a]);
+            sums[a].min = std::min(sums[a].min, minLane(mins[a]));
+            sums[a].max = std::max(sums[a].max, maxLane(maxs[a]));
+        }
+    }
+    return i;
+}
+#endif
+
+} // namespace
+
+void addXyz(std::span<const std::array<int16_t, 3>> samples, std::array<RunningStats, 3>& stats) {
+    if (samples.empty()) {
+        return;
+    }
+
+    std::array<BlockSums, 3> sums;
+    size_t done = 0;
+#ifdef __ARM_NEON
+    done = sumNeon(samples.data(), samples.size(), sums);
+#endif
+    sumScalar(samples.data() + done, samples.size() - done, sums);
+
+    // Turn the sums into the stats of the block and merge them in.
+    const auto count = samples.size();
+    for (size_t a = 0; a < 3; a++) {
+        RunningStats block;
+        block.m_count = count;
+        block.m_mean = double(sums[a].sum) / count;
+        block.m_m2 = std::max(double(sums[a].sumSquares) - double(sums[a].sum) * block.m_mean, 0.0);
+        block.m_min = sums[a].min;
+        block.m_max = sums[a].max;
+        stats[a].merge(block);
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+// The mean, variance, min and max of a stream, updated with Welford's method so it never stores the values.
+class RunningStats {
+public:
+    void add(double value);
+
+    // Combines the stats of two streams as if every value had been added to this one.
+    void merge(const RunningStats& other);
+
+    void reset() { *this = RunningStats(); }
+
+    size_t count() const { return m_count; }
+    double mean() const { return m_mean; }
+    // The population variance, 0 until there are values.
+    double variance() const { return m_count == 0 ? 0.0 : m_m2 / m_count; }
+    double stddev() const;
+    double min() const { return m_min; }
+    double max() const { return m_max; }
+
+private:
+    friend void addXyz(std::span<const std::array<int16_t, 3>> samples, std::array<RunningStats, 3>& stats);
+
+    size_t m_count = 0;
+    double m_mean = 0.0;
+    double m_m2 = 0.0;
+    double m_min = std::numeric_limits<double>::infinity();
+    double m_max = -std::numeric_limits<double>::infinity();
+};
+
+// Counts values into equal bins between min and max, so percentiles need no sorting and no allocation.
+// Values outside the range are counted in the end bins.
+class Histogram {
+public:
+    static constexpr size_t NUM_BINS = 256;
+
+    Histogram(float min, float max);
+
+    void add(float value);
+    void reset();
+
+    size_t count() const { return m_count; }
+
+    // The value below which the fraction p of the values fall, interpolated within its bin.
+    float percentile(float p) const;
+
+private:
+    const float m_min;
+    const float m_width;
+    std::array<uint32_t, NUM_BINS> m_bins = {};
+    size_t m_count = 0;
+};
+
+// Adds interleaved x, y, z samples to one accumulator per axis.
+// Uses NEON when available, and exact integer sums otherwise, which the compiler vectorizes.
+void addXyz(std::span<const std::array<int16_t, 3>> samples, std::array<RunningStats, 3>& stats);
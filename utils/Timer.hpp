@@ -2,6 +2,7 @@
 
 #include <chrono>
 
+#include "Clock.hpp"
 #include "Duration.hpp"
 
 class Timer {
@@ -15,8 +16,6 @@ public:
     bool running() const { return m_running; }
 
 private:
-    using Clock = std::chrono::high_resolution_clock;
-
     Clock::time_point m_timeStart;
     Clock::time_point m_timeStop;
     bool m_running = false;
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include "Ads1115Model.hpp"
+
+namespace wiring {
+
+constexpr uint16_t OS = 0x8000;
+constexpr uint16_t SINGLE_SHOT = 0x0100;
+constexpr uint16_t COMP_QUE = 0x0003;
+constexpr uint16_t THRESH_MSB = 0x8000;
+constexpr std::array<int, 8> RATES = {8, 16, 32, 64, 128, 250, 475, 860};
+constexpr std::array<float, 8> RANGES = {6.144f, 4.096f, 2.048f, 1.024f, 0.512f, 0.256f, 0.256f, 0.256f};
+// The inputs of the differential pairs in MUX codes 0-3, then the single ended inputs against ground.
+constexpr std::array<std::pair<int, int>, 8> PAIRS = {{{0, 1}, {0, 3}, {1, 3}, {2, 3}, {0, -1}, {1, -1}, {2, -1}, {3, -1}}};
+
+constexpr float BATTERY = 7.4f;
+constexpr float BATTERY_SAG = 0.3f;
+constexpr float DIVIDER = 3.0f;
+constexpr float SENSE_IDLE = 0.5f;
+constexpr float SENSE_SWING = 0.2f;
+constexpr float POT_PERIOD = 4.0f;
+constexpr float SUPPLY = 3.3f;
+
+Ads1115Model::Ads1115Model(Interrupt ready) :
+    m_registers({0x0000, 0x8583, 0x8000, 0x7FFF}),
+    m_ready(std::move(ready))
+{}
+
+Ads1115Model::~Ads1115Model() {
+    if (m_thread.joinable()) {
+        {
+            const std::lock_guard lock(m_readyMutex);
+            m_stop = true;
+        }
+        m_readyWake.notify_one();
+        m_thread.join();
+    }
+}
+
+float Ads1115Model::voltage(int input, Clock::time_point time) {
+    const auto t = std::chrono::duration<float>(time.time_since_epoch()).count();
+    const auto phase = 2.0f * std::numbers::pi_v<float> * t;
+    switch (input) {
+    case 0: return (BATTERY - BATTERY_SAG * (0.5f + 0.5f * std::sin(0.1f * phase))) / DIVIDER;
+    case 1: return SENSE_IDLE + SENSE_SWING * std::sin(phase);
+    // A triangle wave from rail to rail.
+    case 2: return SUPPLY * std::abs(2.0f * (t / POT_PERIOD - std::floor(t / POT_PERIOD + 0.5f)));
+    default: return 0.0f;
+    }
+}
+
+Clock::duration Ads1115Model::period() const {
+    const auto rate = RATES[(m_registers[CONFIG] >> 5) & 0x7];
+    return std::chrono::nanoseconds(1'000'000'000LL / rate);
+}
+
+bool Ads1115Model::continuous() const {
+    return (m_registers[CONFIG] & SINGLE_SHOT) == 0;
+}
+
+int16_t Ads1115Model::measure(Clock::time_point time) const {
+    const auto [pos, neg] = PAIRS[(m_registers[CONFIG] >> 12) & 0x7];
+    const auto range = RANGES[(m_registers[CONFIG] >> 9) & 0x7];
+    const auto volts = voltage(pos, time) - (neg < 0 ? 0.0f : voltage(neg, time));
+    return int16_t(std::clamp(std::lround(volts / range * 32768.0f), -32768L, 32767L));
+}
+
+void Ads1115Model::convert() {
+    const auto now = Clock::now();
+    const auto step = period();
+    if (continuous()) {
+        const auto done = (now - m_start) / step;
+        if (done > 0) {
+            m_registers[CONVERSION] = measure(m_start + done * step);
+        }
+    }
+    else if (m_busy && now - m_start >= step) {
+        m_registers[CONVERSION] = measure(m_start + step);
+        m_busy = false;
+    }
+}
+
+uint8_t Ads1115Model::read(uint8_t reg) {
+    const auto index = reg & ~LSB & 0x3;
+    // The whole register is latched when its first byte is read.
+    if (index == CONVERSION && (reg & LSB) == 0) {
+        convert();
+    }
+
+    auto value = m_registers[index];
+    if (index == CONFIG) {
+        convert();
+        // OS reads as set while no single shot conversion is running.
+        value = (value & ~OS) | (m_busy ? 0 : OS);
+    }
+    return (reg & LSB) != 0 ? value & 0xFF : value >> 8;
+}
+
+void Ads1115Model::write(uint8_t reg, uint8_t data) {
+    if ((reg & LSB) == 0) {
+        m_msb = data;
+        return;
+    }
+
+    const auto index = reg & ~LSB & 0x3;
+    const uint16_t value = (uint16_t(m_msb) << 8) | data;
+    if (index != CONFIG) {
+        m_registers[index] = value;
+        updateReady();
+        return;
+    }
+
+    // OS only starts a conversion and is not kept.
+    m_registers[CONFIG] = value & ~OS;
+    if (continuous() || (value & OS) != 0) {
+        m_start = Clock::now();
+        m_busy = !continuous();
+        m_starts++;
+    }
+    updateReady();
+}
+
+void Ads1115Model::updateReady() {
+    if (!m_ready) {
+        return;
+    }
+
+    const bool enabled = (m_registers[CONFIG] & COMP_QUE) != COMP_QUE
+        && (m_registers[HI_THRESH] & THRESH_MSB) != 0 && (m_registers[LO_THRESH] & THRESH_MSB) == 0
+        && (continuous() || m_busy);
+    {
+        const std::lock_guard lock(m_readyMutex);
+        const auto step = std::chrono::duration_cast<std::chrono::steady_clock::duration>(period());
+        m_readyAt = enabled ? std::chrono::steady_clock::now() + step : std::chrono::steady_clock::time_point::max();
+        m_readyPeriod = continuous() ? step : std::chrono::steady_clock::duration::zero();
+        // The thread is only started once something asks for the signal and then lives as long as the model.
+        if (enabled && !m_thread.joinable()) {
+            m_thread = std::thread(&Ads1115Model::signal, this);
+        }
+    }
+    m_readyWake.notify_one();
+}
+
+void Ads1115Model::signal() {
+    std::unique_lock lock(m_readyMutex);
+    while (!m_stop) {
+        if (std::chrono::steady_clock::now() < m_readyAt) {
+            if (m_readyAt == std::chrono::steady_clock::time_point::max()) {
+                m_readyWake.wait(lock);
+            }
+            else {
+                m_readyWake.wait_until(lock, m_readyAt);
+            }
+            continue;
+        }
+
+        m_readyAt = m_readyPeriod == std::chrono::steady_clock::duration::zero() ? std::chrono::steady_clock::time_point::max() : m_readyAt + m_readyPeriod;
+        // The chip pulls the pin low when a conversion is done. Raising it first makes that an edge every time,
+        // and whatever the edge sets off may write the registers again, so the lock is let go.
+        lock.unlock();
+        m_ready(true);
+        m_ready(false);
+        lock.lock();
+    }
+}
+
+} // namespace wiring
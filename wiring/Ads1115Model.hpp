@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "utils/Clock.hpp"
+#include "utils/Function.hpp"
+
+#include "SimBackend.hpp"
+
+namespace wiring {
+
+// A simulated ADS1115 with a 2S battery behind a 1:3 divider on AIN0, a current sense amplifier on AIN1
+// and a pot swept back and forth on AIN2, with AIN3 grounded.
+// Conversions finish at the data rate and are a function of the Clock, like the Mpu6050Model.
+// With the ready thresholds set and the comparator on, a thread signals ALERT/RDY at the end of each conversion.
+class Ads1115Model : public I2cModel {
+public:
+    static constexpr uint8_t ADDRESS = 0x48;
+
+    static constexpr uint8_t CONVERSION = 0x00;
+    static constexpr uint8_t CONFIG     = 0x01;
+    static constexpr uint8_t LO_THRESH  = 0x02;
+    static constexpr uint8_t HI_THRESH  = 0x03;
+    // The registers are 16 bit and sent MSB first, so the second byte of each is addressed with this set.
+    static constexpr uint8_t LSB = 0x80;
+
+    using Interrupt = Function<void(bool level)>;
+
+    // ready drives whatever the ALERT/RDY pin is wired to.
+    Ads1115Model(Interrupt ready = nullptr);
+    ~Ads1115Model() override;
+
+    uint8_t read(uint8_t reg) override;
+    void write(uint8_t reg, uint8_t data) override;
+
+    uint8_t next(uint8_t reg) const override { return reg | LSB; }
+
+    // The voltage at AIN0-3 at time.
+    static float voltage(int input, Clock::time_point time);
+
+    // Conversions started by a single shot, or restarted by a config write in continuous mode.
+    size_t starts() const { return m_starts; }
+
+private:
+    Clock::duration period() const;
+    bool continuous() const;
+    // Moves the conversion register on to the last conversion that has finished.
+    void convert();
+    int16_t measure(Clock::time_point time) const;
+
+    // Restarts or stops the ALERT/RDY signal to match the registers.
+    void updateReady();
+    void signal();
+
+    std::array<uint16_t, 4> m_registers;
+    uint8_t m_msb = 0;
+    // The last conversion to start, and whether it is still running in single shot mode.
+    Clock::time_point m_start;
+    bool m_busy = false;
+    size_t m_starts = 0;
+
+    const Interrupt m_ready;
+    std::mutex m_readyMutex;
+    std::condition_variable m_readyWake;
+    // The next time to signal, or max while there is nothing to signal, and the period to repeat it in continuous mode.
+    std::chrono::steady_clock::time_point m_readyAt = std::chrono::steady_clock::time_point::max();
+    std::chrono::steady_clock::duration m_readyPeriod = {};
+    bool m_stop = false;
+    std::thread m_thread;
+};
+
+} // namespace wiring
@@ -0,0 +1,78 @@
+#include <format>
+#include <stdexcept>
+#include <thread>
+
+#include "utils/Enum.hpp"
+#include "utils/Logger.hpp"
+
+#include "Backend.hpp"
+#include "Bank.hpp"
+#include "GpiochipBackend.hpp"
+#include "PigpioBackend.hpp"
+#include "SimBackend.hpp"
+
+namespace wiring {
+
+CREATE_ENUM_SET(BackendType, PIGPIO, GPIOCHIP, SIM)
+
+std::unique_ptr<Backend> Backend::s_backend;
+
+Backend& Backend::get() {
+    if (s_backend == nullptr) {
+#ifdef RAPPY_PIGPIO
+        s_backend = std::make_unique<PigpioBackend>();
+#else
+        s_backend = std::make_unique<SimBackend>();
+#endif
+    }
+    return *s_backend;
+}
+
+void Backend::select(std::string_view name) {
+    const auto colon = name.find(':');
+    const auto type = BackendTypeFromString(name.substr(0, colon));
+    logger.debug() << "wiring::Backend::select(): " << name;
+    switch (type) {
+    case BackendType::PIGPIO:
+#ifdef RAPPY_PIGPIO
+        s_backend = std::make_unique<PigpioBackend>();
+        break;
+#else
+        throw std::invalid_argument("wiring::Backend::select(): Built without pigpio");
+#endif
+    case BackendType::GPIOCHIP:
+        s_backend = colon == std::string_view::npos ?
+            std::make_unique<GpiochipBackend>() :
+            std::make_unique<GpiochipBackend>(name.substr(colon + 1));
+        break;
+    case BackendType::SIM: s_backend = std::make_unique<SimBackend>(); break;
+    default: throw std::invalid_argument(std::format("Unrecognized backend: {}", name));
+    }
+    Bank::get().reset();
+}
+
+void Backend::write(uint64_t mask, uint64_t levels) {
+    for (int pin = 0; mask != 0; pin++, mask >>= 1) {
+        if ((mask & 1) != 0) {
+            write(pin, ((levels >> pin) & 1) != 0);
+        }
+    }
+}
+
+void Backend::trigger(int pin, Clock::duration pulse, bool level) {
+    write(pin, level);
+    std::this_thread::sleep_for(pulse);
+    write(pin, !level);
+}
+
+uint64_t Backend::read(uint64_t mask) {
+    uint64_t levels = 0;
+    for (int pin = 0; mask != 0; pin++, mask >>= 1) {
+        if ((mask & 1) != 0 && read(pin)) {
+            levels |= uint64_t(1) << pin;
+        }
+    }
+    return levels;
+}
+
+} // namespace wiring
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+
+#include "utils/Clock.hpp"
+#include "utils/Function.hpp"
+
+#include "PinConfig.hpp"
+
+namespace wiring {
+
+// Everything the wiring layer needs from the hardware.
+// Pins are broadcom numbers and I2C devices are referred to by the handle returned from i2cOpen().
+class Backend {
+public:
+    // Called with the pin, its new level and when the edge happened.
+    using Alert = Function<void(int, bool, Clock::time_point)>;
+
+    virtual ~Backend() {}
+
+    // The backend used by every pin and device. Defaults to pigpio when it is built in and the simulation otherwise.
+    static Backend& get();
+
+    // Switches the backend by name: pigpio, gpiochip or sim.
+    // The gpiochip backend takes an optional device, e.g. gpiochip:/dev/gpiochip1.
+    // Must be called before any pin or device is created.
+    static void select(std::string_view name);
+
+    // Called when the first pin or device is created and after the last one is destroyed.
+    virtual void initialise() = 0;
+    virtual void terminate() = 0;
+
+    virtual void setMode(int pin, PinMode mode) = 0;
+
+    virtual void write(int pin, bool level) = 0;
+    virtual bool read(int pin) = 0;
+
+    // Sets every pin in mask to its bit in levels, in as few calls as the hardware allows.
+    virtual void write(uint64_t mask, uint64_t levels);
+
+    // Reads every pin in mask into its bit.
+    virtual uint64_t read(uint64_t mask);
+
+    // Holds an output pin at level for pulse, then back, like the trigger of an ultrasonic ranger.
+    virtual void trigger(int pin, Clock::duration pulse, bool level = true);
+
+    // Calls alert from a backend thread on every edge of an input pin. An empty alert stops them.
+    virtual void setAlert(int pin, Alert alert) = 0;
+
+    // Ignores edges of an input pin until its level has been steady for the duration. Zero turns it off.
+    virtual void setGlitchFilter(int pin, Clock::duration steady) = 0;
+
+    virtual void setPwmRange(int pin, int range) = 0;
+    virtual int pwmRange(int pin) = 0;
+    virtual void setPwmFrequency(int pin, int freq) = 0;
+    virtual void pwm(int pin, int duty) = 0;
+
+    // pulseWidth is in us.
+    virtual void servo(int pin, int pulseWidth) = 0;
+
+    virtual unsigned i2cOpen(unsigned bus, uint8_t address) = 0;
+    virtual void i2cClose(unsigned handle) = 0;
+
+    virtual void i2cWriteByte(unsigned handle, uint8_t reg, uint8_t data) = 0;
+    virtual uint8_t i2cReadByte(unsigned handle, uint8_t reg) = 0;
+
+    // Words are in SMBus order, the low byte is at reg and the high byte at reg + 1.
+    virtual void i2cWriteWord(unsigned handle, uint8_t reg, uint16_t data) = 0;
+    virtual uint16_t i2cReadWord(unsigned handle, uint8_t reg) = 0;
+
+    // Writes or reads consecutive registers starting at reg in a single transaction.
+    virtual void i2cWriteBlock(unsigned handle, uint8_t reg, std::span<const uint8_t> data) = 0;
+    virtual void i2cReadBlock(unsigned handle, uint8_t reg, std::span<uint8_t> data) = 0;
+
+private:
+    static std::unique_ptr<Backend> s_backend;
+};
+
+} // namespace wiring
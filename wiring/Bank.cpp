@@ -0,0 +1,144 @@
+#include <bit>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+#include "Bank.hpp"
+
+namespace wiring {
+
+Bank::Bank() {
+    m_appliedValues.fill(UNKNOWN);
+}
+
+Bank& Bank::get() {
+    static Bank bank;
+    return bank;
+}
+
+void Bank::reset() {
+    const auto deferred = m_deferred;
+    auto devices = std::move(m_devices);
+    *this = Bank();
+    m_deferred = deferred;
+    m_devices = std::move(devices);
+}
+
+void Bank::add(StagedDevice* device) {
+    m_devices.push_back(device);
+}
+
+void Bank::remove(StagedDevice* device) {
+    std::erase(m_devices, device);
+}
+
+void Bank::setMode(int pin, PinMode mode) {
+    if (pin < 0 || pin >= NUM_PINS) {
+        throw std::invalid_argument(std::format("wiring::Bank::setMode(): Pin is out of range 0-{}: {}", NUM_PINS - 1, pin));
+    }
+    Backend::get().setMode(pin, mode);
+    m_modes[pin] = mode;
+    forget(pin);
+
+    const auto bit = uint64_t(1) << pin;
+    m_inputs = mode == PinMode::IN ? m_inputs | bit : m_inputs & ~bit;
+    if (mode == PinMode::IN) {
+        m_sampled = Backend::get().read(pin) ? m_sampled | bit : m_sampled & ~bit;
+    }
+}
+
+void Bank::forget(int pin) {
+    const auto bit = uint64_t(1) << pin;
+    m_dirty &= ~bit;
+    m_known &= ~bit;
+    m_dirtyValues &= ~bit;
+    m_appliedValues[pin] = UNKNOWN;
+}
+
+void Bank::setPwmRange(int pin, int range) {
+    Backend::get().setPwmRange(pin, range);
+    m_pwmRanges[pin] = Backend::get().pwmRange(pin);
+}
+
+void Bank::write(int pin, bool level) {
+    // Writing a level makes any pin a digital output, like gpioWrite() does.
+    // Bulk writes only set the level, so the mode has to be switched explicitly.
+    if (m_modes[pin] != PinMode::OUT) {
+        setMode(pin, PinMode::OUT);
+    }
+
+    const auto bit = uint64_t(1) << pin;
+    m_counters.writes++;
+    m_counters.dropped += (m_dirty & bit) != 0;
+    m_dirty |= bit;
+    m_staged = level ? m_staged | bit : m_staged & ~bit;
+    if (!m_deferred) {
+        commit();
+    }
+}
+
+void Bank::stage(int pin, int value) {
+    const auto bit = uint64_t(1) << pin;
+    m_counters.writes++;
+    m_counters.dropped += (m_dirtyValues & bit) != 0;
+    m_dirtyValues |= bit;
+    m_stagedValues[pin] = value;
+    if (!m_deferred) {
+        commit();
+    }
+}
+
+bool Bank::read(int pin) {
+    m_counters.reads++;
+    if (!m_deferred) {
+        m_counters.calls++;
+        return Backend::get().read(pin);
+    }
+    return ((m_sampled >> pin) & 1) != 0;
+}
+
+void Bank::sample() {
+    if (m_inputs != 0) {
+        m_sampled = Backend::get().read(m_inputs);
+        m_counters.calls++;
+    }
+}
+
+void Bank::commit() {
+    auto& backend = Backend::get();
+
+    if (m_dirty != 0) {
+        const auto changed = m_dirty & (~m_known | (m_staged ^ m_applied));
+        m_counters.dropped += std::popcount(m_dirty & ~changed);
+        if (changed != 0) {
+            backend.write(changed, m_staged);
+            m_counters.calls++;
+            m_applied = (m_applied & ~changed) | (m_staged & changed);
+            m_known |= changed;
+        }
+        m_dirty = 0;
+    }
+
+    for (auto dirty = m_dirtyValues; dirty != 0; dirty &= dirty - 1) {
+        const auto pin = std::countr_zero(dirty);
+        const auto value = m_stagedValues[pin];
+        if (value == m_appliedValues[pin]) {
+            m_counters.dropped++;
+            continue;
+        }
+        switch (m_modes[pin]) {
+        case PinMode::PWM:   backend.pwm(pin, value); break;
+        case PinMode::SERVO: backend.servo(pin, value); break;
+        default: throw std::logic_error(std::format("wiring::Bank::commit(): Pin {} is not a PWM or servo pin", pin));
+        }
+        m_counters.calls++;
+        m_appliedValues[pin] = value;
+    }
+    m_dirtyValues = 0;
+
+    for (auto* device : m_devices) {
+        device->commit();
+    }
+}
+
+} // namespace wiring
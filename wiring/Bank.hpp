@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Backend.hpp"
+#include "PinConfig.hpp"
+
+namespace wiring {
+
+// Hardware that stages its own writes, like an I2C expander, and applies them when the Bank commits.
+class StagedDevice {
+public:
+    virtual ~StagedDevice() {}
+
+    virtual void commit() = 0;
+};
+
+// Sits between the pins and the backend and remembers what the hardware was last set to.
+// Output writes are staged and applied by commit(), which drops the ones that would not change anything
+// and sets every digital output with a single bulk write.
+// Inputs are read from a snapshot of every input pin that sample() takes with a single bulk read.
+class Bank {
+public:
+    struct Counters {
+        // Writes and reads made by the pins.
+        uint64_t writes = 0;
+        uint64_t reads = 0;
+        // Writes that were dropped because they matched the hardware or were overwritten before the commit.
+        uint64_t dropped = 0;
+        // Calls made to the backend.
+        uint64_t calls = 0;
+    };
+
+    static Bank& get();
+
+    // Forgets everything, for when the backend changes.
+    void reset();
+
+    // Commits every write and reads every input straight away unless deferred,
+    // in which case the owner calls sample() and commit() once per tick.
+    void setDeferred(bool deferred) { m_deferred = deferred; }
+    bool deferred() const { return m_deferred; }
+
+    // Commits the device along with the pins until it is removed.
+    void add(StagedDevice* device);
+    void remove(StagedDevice* device);
+
+    void setMode(int pin, PinMode mode);
+
+    void write(int pin, bool level);
+
+    void setPwmRange(int pin, int range);
+    int pwmRange(int pin) const { return m_pwmRanges[pin]; }
+    void setPwmFrequency(int pin, int freq) { Backend::get().setPwmFrequency(pin, freq); }
+    void pwm(int pin, int duty) { stage(pin, duty); }
+
+    // pulseWidth is in us.
+    void servo(int pin, int pulseWidth) { stage(pin, pulseWidth); }
+
+    bool read(int pin);
+
+    // Snapshots every input pin.
+    void sample();
+
+    // Applies the staged writes, then commits every device.
+    void commit();
+
+    const Counters& counters() const { return m_counters; }
+
+private:
+    static constexpr int NUM_PINS = 54;
+    static constexpr int UNKNOWN = -1;
+
+    Bank();
+
+    // Marks the pin as being in an unknown state.
+    void forget(int pin);
+    void stage(int pin, int value);
+
+    bool m_deferred = false;
+    std::array<PinMode, NUM_PINS> m_modes = {};
+    std::array<int, NUM_PINS> m_pwmRanges = {};
+
+    // Digital inputs, one bit per pin.
+    uint64_t m_inputs = 0;
+    uint64_t m_sampled = 0;
+
+    // Digital outputs, one bit per pin.
+    uint64_t m_dirty = 0;
+    uint64_t m_staged = 0;
+    uint64_t m_known = 0;
+    uint64_t m_applied = 0;
+
+    // PWM duty cycles and servo pulse widths.
+    uint64_t m_dirtyValues = 0;
+    std::array<int, NUM_PINS> m_stagedValues = {};
+    std::array<int, NUM_PINS> m_appliedValues = {};
+
+    std::vector<StagedDevice*> m_devices;
+
+    Counters m_counters;
+};
+
+} // namespace wiring
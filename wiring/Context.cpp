@@ -1,10 +1,7 @@
 #include <format>
 #include <stdexcept>
 
-#include <pigpio.h>
-
-#include "utils/PigpioError.hpp"
-
+#include "Backend.hpp"
 #include "Context.hpp"
 
 namespace wiring {
@@ -20,8 +17,7 @@ Context::Context(int pin) : m_pin(pin) {
     }
 
     if (s_instances++ == 0) {
-        const auto res = gpioInitialise();
-        pigpio::checkError(res);
+        Backend::get().initialise();
     }
 
     PinFlag flag = 1 << m_pin;
@@ -36,7 +32,7 @@ Context::~Context() {
     s_usedPins &= mask;
     
     if (--s_instances == 0) {
-        gpioTerminate();
+        Backend::get().terminate();
     }
 }
 
@@ -0,0 +1,60 @@
+#include <chrono>
+#include <cmath>
+
+#include "EncoderModel.hpp"
+
+namespace wiring {
+
+// The levels of A and B at each position, modulo 4.
+constexpr bool LEVEL_A[] = {false, true, true, false};
+constexpr bool LEVEL_B[] = {false, false, true, true};
+// How long the thread sleeps at a time while the shaft is stopped.
+constexpr auto IDLE = std::chrono::milliseconds(5);
+
+EncoderModel::EncoderModel(Drive drive) :
+    m_drive(std::move(drive))
+{}
+
+EncoderModel::~EncoderModel() {
+    m_stop = true;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void EncoderModel::setSpeed(float speed) {
+    m_speed.store(speed, std::memory_order_relaxed);
+    // Only ever started from the thread setting the speed.
+    if (speed != 0.0f && !m_thread.joinable()) {
+        m_thread = std::thread(&EncoderModel::run, this);
+    }
+}
+
+void EncoderModel::run() {
+    auto next = std::chrono::steady_clock::now();
+    while (!m_stop) {
+        const auto speed = m_speed.load(std::memory_order_relaxed);
+        if (speed == 0.0f) {
+            std::this_thread::sleep_for(IDLE);
+            next = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        // Each step is scheduled from the last rather than from now, so the speed holds on average when sleeps overrun.
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(1.0f / std::abs(speed)));
+        std::this_thread::sleep_until(next);
+
+        const auto from = m_position.load(std::memory_order_relaxed);
+        const auto to = from + (speed > 0.0f ? 1 : -1);
+        const auto phase = size_t(to & 3);
+        // Only one of the pins changes between neighbouring positions.
+        if (LEVEL_A[phase] != LEVEL_A[size_t(from & 3)]) {
+            m_drive(0, LEVEL_A[phase]);
+        } else {
+            m_drive(1, LEVEL_B[phase]);
+        }
+        m_position.store(to, std::memory_order_release);
+    }
+}
+
+} // namespace wiring
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "utils/Function.hpp"
+
+namespace wiring {
+
+// A simulated quadrature encoder on a shaft turning at a set speed.
+// A thread steps A and B through 00, 01, 11, 10 when going forward, with A leading, and falls behind rather than
+// skipping states when it can't keep up, so every count reaches the pins.
+class EncoderModel {
+public:
+    // Drives whatever channel A (0) or B (1) is wired to.
+    using Drive = Function<void(int channel, bool level)>;
+
+    EncoderModel(Drive drive);
+    ~EncoderModel();
+
+    EncoderModel(const EncoderModel&) = delete;
+    EncoderModel& operator=(const EncoderModel&) = delete;
+
+    // In counts per second, negative going backwards. The first non-zero speed starts the thread.
+    void setSpeed(float speed);
+    float speed() const { return m_speed.load(std::memory_order_relaxed); }
+
+    // The counts stepped so far.
+    int64_t position() const { return m_position.load(std::memory_order_acquire); }
+
+private:
+    void run();
+
+    const Drive m_drive;
+    std::atomic<float> m_speed = 0.0f;
+    std::atomic<int64_t> m_position = 0;
+    std::atomic<bool> m_stop = false;
+    std::thread m_thread;
+};
+
+} // namespace wiring
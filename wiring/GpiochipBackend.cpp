@@ -0,0 +1,433 @@
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "utils/Logger.hpp"
+#include "utils/Other.hpp"
+
+#include "GpiochipBackend.hpp"
+
+namespace wiring {
+
+constexpr size_t MAX_EVENTS = 16;
+constexpr char CONSUMER[] = "rappy";
+
+[[noreturn]] void throwErrno(std::string_view what) {
+    throw std::system_error(errno, std::generic_category(), std::format("wiring::GpiochipBackend: {}", what));
+}
+
+GpiochipBackend::GpiochipBackend(std::string_view path) : m_path(path) {
+    m_lines.fill(-1);
+}
+
+GpiochipBackend::~GpiochipBackend() {
+    terminate();
+}
+
+void GpiochipBackend::initialise() {
+    if (m_chip >= 0) {
+        return;
+    }
+    m_chip = open(m_path.c_str(), O_RDWR | O_CLOEXEC);
+    if (m_chip < 0) {
+        throwErrno(std::format("open {}", m_path));
+    }
+    logger.debug() << "wiring::GpiochipBackend::initialise(): Opened " << m_path;
+}
+
+void GpiochipBackend::terminate() {
+    release();
+    for (auto& fd : m_i2cFds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    m_i2cFds.clear();
+    m_i2cAddresses.clear();
+    if (m_chip >= 0) {
+        close(m_chip);
+        m_chip = -1;
+    }
+    m_modes = {};
+    m_alerts = {};
+    m_debounce = {};
+    const std::lock_guard lock(m_outputMutex);
+    m_outputs = 0;
+    m_levels = 0;
+}
+
+void GpiochipBackend::checkPin(int pin) const {
+    if (pin < 0 || pin >= NUM_PINS) {
+        throw std::invalid_argument(std::format("wiring::GpiochipBackend: Pin is out of range 0-{}: {}", NUM_PINS - 1, pin));
+    }
+}
+
+void GpiochipBackend::setMode(int pin, PinMode mode) {
+    checkPin(pin);
+    if (mode != PinMode::IN && mode != PinMode::OUT) {
+        throw std::invalid_argument(std::format("wiring::GpiochipBackend::setMode(): Only in and out pins are supported, not {}", to_underlying(mode)));
+    }
+    if (m_modes[pin] == mode) {
+        return;
+    }
+    m_modes[pin] = mode;
+    const auto bit = uint64_t(1) << pin;
+    {
+        const std::lock_guard lock(m_outputMutex);
+        m_outputs = mode == PinMode::OUT ? m_outputs | bit : m_outputs & ~bit;
+    }
+    request();
+}
+
+void GpiochipBackend::setAlert(int pin, Alert alert) {
+    checkPin(pin);
+    // Stop the event thread before touching the alerts it reads.
+    release();
+    m_alerts[pin] = std::move(alert);
+    request();
+}
+
+void GpiochipBackend::setGlitchFilter(int pin, Clock::duration steady) {
+    checkPin(pin);
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(steady).count();
+    if (m_debounce[pin] == us) {
+        return;
+    }
+    release();
+    m_debounce[pin] = us;
+    request();
+}
+
+void GpiochipBackend::release() {
+    if (m_thread.joinable()) {
+        const uint64_t one = 1;
+        if (::write(m_wake, &one, sizeof(one)) < 0) {
+            logger.error() << "wiring::GpiochipBackend::release(): Failed to wake the event thread";
+        }
+        m_thread.join();
+    }
+    if (m_wake >= 0) {
+        close(m_wake);
+        m_wake = -1;
+    }
+    if (m_request >= 0) {
+        close(m_request);
+        m_request = -1;
+    }
+    m_lines.fill(-1);
+    m_pins.clear();
+}
+
+void GpiochipBackend::request() {
+    initialise();
+    release();
+
+    gpio_v2_line_request req{};
+    uint64_t outputs = 0;
+    uint64_t edges = 0;
+    for (int pin = 0; pin < NUM_PINS; pin++) {
+        if (m_modes[pin] == PinMode::NONE && !m_alerts[pin]) {
+            continue;
+        }
+        const auto line = m_pins.size();
+        m_lines[pin] = line;
+        m_pins.push_back(pin);
+        req.offsets[line] = pin;
+        if (m_modes[pin] == PinMode::OUT) {
+            outputs |= uint64_t(1) << line;
+        }
+        else if (m_alerts[pin]) {
+            edges |= uint64_t(1) << line;
+        }
+    }
+    if (m_pins.empty()) {
+        return;
+    }
+
+    std::strncpy(req.consumer, CONSUMER, sizeof(req.consumer) - 1);
+    req.num_lines = m_pins.size();
+    req.event_buffer_size = MAX_EVENTS * m_pins.size();
+    req.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+
+    auto& attrs = req.config.attrs;
+    auto& numAttrs = req.config.num_attrs;
+    if (outputs != 0) {
+        attrs[numAttrs].attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+        attrs[numAttrs].attr.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+        attrs[numAttrs].mask = outputs;
+        numAttrs++;
+        attrs[numAttrs].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        {
+            const std::lock_guard lock(m_outputMutex);
+            attrs[numAttrs].attr.values = toLines(m_levels);
+        }
+        attrs[numAttrs].mask = outputs;
+        numAttrs++;
+    }
+    if (edges != 0) {
+        attrs[numAttrs].attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+        attrs[numAttrs].attr.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+        attrs[numAttrs].mask = edges;
+        numAttrs++;
+    }
+
+    // Each distinct debounce period takes an attribute of its own.
+    for (size_t line = 0; line < m_pins.size(); line++) {
+        const auto period = m_debounce[m_pins[line]];
+        if (period == 0) {
+            continue;
+        }
+        uint32_t i = 0;
+        while (i < numAttrs && !(attrs[i].attr.id == GPIO_V2_LINE_ATTR_ID_DEBOUNCE && attrs[i].attr.debounce_period_us == period)) {
+            i++;
+        }
+        if (i == numAttrs) {
+            if (numAttrs == GPIO_V2_LINE_NUM_ATTRS_MAX) {
+                throw std::invalid_argument("wiring::GpiochipBackend::request(): Too many different glitch filters");
+            }
+            attrs[i].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+            attrs[i].attr.debounce_period_us = period;
+            numAttrs++;
+        }
+        attrs[i].mask |= uint64_t(1) << line;
+    }
+
+    if (ioctl(m_chip, GPIO_V2_GET_LINE_IOCTL, &req) < 0) {
+        const auto error = errno;
+        m_lines.fill(-1);
+        m_pins.clear();
+        errno = error;
+        throwErrno("GPIO_V2_GET_LINE_IOCTL");
+    }
+    m_request = req.fd;
+    logger.debug() << "wiring::GpiochipBackend::request(): Requested " << m_pins.size() << " lines";
+
+    if (edges != 0) {
+        m_wake = eventfd(0, EFD_CLOEXEC);
+        if (m_wake < 0) {
+            throwErrno("eventfd");
+        }
+        m_thread = std::thread(&GpiochipBackend::listen, this);
+    }
+}
+
+uint64_t GpiochipBackend::toLines(uint64_t mask) const {
+    uint64_t lines = 0;
+    for (int pin = 0; mask != 0; pin++, mask >>= 1) {
+        if ((mask & 1) != 0) {
+            if (m_lines[pin] < 0) {
+                throw std::logic_error(std::format("wiring::GpiochipBackend: Pin {} has no mode", pin));
+            }
+            lines |= uint64_t(1) << m_lines[pin];
+        }
+    }
+    return lines;
+}
+
+uint64_t GpiochipBackend::toPins(uint64_t lines) const {
+    uint64_t mask = 0;
+    for (size_t line = 0; lines != 0; line++, lines >>= 1) {
+        if ((lines & 1) != 0) {
+            mask |= uint64_t(1) << m_pins[line];
+        }
+    }
+    return mask;
+}
+
+void GpiochipBackend::write(int pin, bool level) {
+    checkPin(pin);
+    const auto bit = uint64_t(1) << pin;
+    write(bit, level ? bit : 0);
+}
+
+bool GpiochipBackend::read(int pin) {
+    checkPin(pin);
+    const auto bit = uint64_t(1) << pin;
+    return read(bit) != 0;
+}
+
+void GpiochipBackend::write(uint64_t mask, uint64_t levels) {
+    const std::lock_guard lock(m_outputMutex);
+    if ((mask & ~m_outputs) != 0) {
+        throw std::logic_error("wiring::GpiochipBackend::write(): Can only write to output pins");
+    }
+
+    gpio_v2_line_values values{};
+    values.mask = toLines(mask);
+    values.bits = toLines(levels & mask);
+    if (ioctl(m_request, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0) {
+        throwErrno("GPIO_V2_LINE_SET_VALUES_IOCTL");
+    }
+    m_levels = (m_levels & ~mask) | (levels & mask);
+}
+
+uint64_t GpiochipBackend::read(uint64_t mask) {
+    gpio_v2_line_values values{};
+    values.mask = toLines(mask);
+    if (ioctl(m_request, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0) {
+        throwErrno("GPIO_V2_LINE_GET_VALUES_IOCTL");
+    }
+    return toPins(values.bits & values.mask);
+}
+
+void GpiochipBackend::listen() {
+    std::array<gpio_v2_line_event, MAX_EVENTS> events;
+    std::array<pollfd, 2> fds = {{
+        {m_request, POLLIN, 0},
+        {m_wake, POLLIN, 0}
+    }};
+
+    while (true) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            logger.error() << "wiring::GpiochipBackend::listen(): poll failed: " << std::strerror(errno);
+            return;
+        }
+        if ((fds[1].revents & POLLIN) != 0) {
+            return;
+        }
+        if ((fds[0].revents & POLLIN) == 0) {
+            continue;
+        }
+
+        const auto size = ::read(m_request, events.data(), sizeof(events));
+        if (size < 0) {
+            logger.error() << "wiring::GpiochipBackend::listen(): read failed: " << std::strerror(errno);
+            return;
+        }
+        for (size_t i = 0; i < size_t(size) / sizeof(gpio_v2_line_event); i++) {
+            const auto& event = events[i];
+            const auto& alert = m_alerts[event.offset];
+            if (alert) {
+                // The kernel stamps events with CLOCK_MONOTONIC, which the steady clock is based on.
+                alert(event.offset, event.id == GPIO_V2_LINE_EVENT_RISING_EDGE,
+                    Clock::time_point(std::chrono::nanoseconds(event.timestamp_ns)));
+            }
+        }
+    }
+}
+
+void GpiochipBackend::setPwmRange(int pin, int range) {
+    throw std::invalid_argument("wiring::GpiochipBackend: PWM is not supported by the GPIO character device");
+}
+
+int GpiochipBackend::pwmRange(int pin) {
+    throw std::invalid_argument("wiring::GpiochipBackend: PWM is not supported by the GPIO character device");
+}
+
+void GpiochipBackend::setPwmFrequency(int pin, int freq) {
+    throw std::invalid_argument("wiring::GpiochipBackend: PWM is not supported by the GPIO character device");
+}
+
+void GpiochipBackend::pwm(int pin, int duty) {
+    throw std::invalid_argument("wiring::GpiochipBackend: PWM is not supported by the GPIO character device");
+}
+
+void GpiochipBackend::servo(int pin, int pulseWidth) {
+    throw std::invalid_argument("wiring::GpiochipBackend: Servos are not supported by the GPIO character device");
+}
+
+unsigned GpiochipBackend::i2cOpen(unsigned bus, uint8_t address) {
+    const auto path = std::format("/dev/i2c-{}", bus);
+    const int fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        throwErrno(std::format("open {}", path));
+    }
+    if (ioctl(fd, I2C_SLAVE, address) < 0) {
+        const auto error = errno;
+        close(fd);
+        errno = error;
+        throwErrno(std::format("I2C_SLAVE {:#04x}", address));
+    }
+    m_i2cFds.push_back(fd);
+    m_i2cAddresses.push_back(address);
+    return m_i2cFds.size() - 1;
+}
+
+void GpiochipBackend::i2cClose(unsigned handle) {
+    close(i2cFd(handle));
+    m_i2cFds[handle] = -1;
+}
+
+int GpiochipBackend::i2cFd(unsigned handle) const {
+    if (handle >= m_i2cFds.size() || m_i2cFds[handle] < 0) {
+        throw std::invalid_argument(std::format("wiring::GpiochipBackend: Bad I2C handle: {}", handle));
+    }
+    return m_i2cFds[handle];
+}
+
+void GpiochipBackend::smbus(unsigned handle, uint8_t readWrite, uint8_t reg, int size, void* data) const {
+    i2c_smbus_ioctl_data args{readWrite, reg, uint32_t(size), static_cast<i2c_smbus_data*>(data)};
+    if (ioctl(i2cFd(handle), I2C_SMBUS, &args) < 0) {
+        throwErrno("I2C_SMBUS");
+    }
+}
+
+void GpiochipBackend::i2cWriteByte(unsigned handle, uint8_t reg, uint8_t data) {
+    i2c_smbus_data smbusData{};
+    smbusData.byte = data;
+    smbus(handle, I2C_SMBUS_WRITE, reg, I2C_SMBUS_BYTE_DATA, &smbusData);
+}
+
+uint8_t GpiochipBackend::i2cReadByte(unsigned handle, uint8_t reg) {
+    i2c_smbus_data smbusData{};
+    smbus(handle, I2C_SMBUS_READ, reg, I2C_SMBUS_BYTE_DATA, &smbusData);
+    return smbusData.byte;
+}
+
+void GpiochipBackend::i2cWriteWord(unsigned handle, uint8_t reg, uint16_t data) {
+    i2c_smbus_data smbusData{};
+    smbusData.word = data;
+    smbus(handle, I2C_SMBUS_WRITE, reg, I2C_SMBUS_WORD_DATA, &smbusData);
+}
+
+uint16_t GpiochipBackend::i2cReadWord(unsigned handle, uint8_t reg) {
+    i2c_smbus_data smbusData{};
+    smbus(handle, I2C_SMBUS_READ, reg, I2C_SMBUS_WORD_DATA, &smbusData);
+    return smbusData.word;
+}
+
+void GpiochipBackend::i2cWriteBlock(unsigned handle, uint8_t reg, std::span<const uint8_t> data) {
+    constexpr size_t MAX_BLOCK = 64;
+    const int fd = i2cFd(handle);
+    if (data.size() > MAX_BLOCK) {
+        throw std::invalid_argument(std::format("wiring::GpiochipBackend::i2cWriteBlock(): Blocks are at most {} bytes", MAX_BLOCK));
+    }
+    std::array<uint8_t, MAX_BLOCK + 1> buffer;
+    buffer[0] = reg;
+    std::memcpy(buffer.data() + 1, data.data(), data.size());
+
+    i2c_msg msg{m_i2cAddresses[handle], 0, uint16_t(data.size() + 1), buffer.data()};
+    i2c_rdwr_ioctl_data args{&msg, 1};
+    if (ioctl(fd, I2C_RDWR, &args) < 0) {
+        throwErrno("I2C_RDWR");
+    }
+}
+
+void GpiochipBackend::i2cReadBlock(unsigned handle, uint8_t reg, std::span<uint8_t> data) {
+    // Writing the register and reading it back with a repeated start has no 32 byte SMBus limit.
+    const int fd = i2cFd(handle);
+    std::array<i2c_msg, 2> msgs = {{
+        {m_i2cAddresses[handle], 0, 1, &reg},
+        {m_i2cAddresses[handle], I2C_M_RD, uint16_t(data.size()), data.data()}
+    }};
+    i2c_rdwr_ioctl_data args{msgs.data(), msgs.size()};
+    if (ioctl(fd, I2C_RDWR, &args) < 0) {
+        throwErrno("I2C_RDWR");
+    }
+}
+
+} // namespace wiring
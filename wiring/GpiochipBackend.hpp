@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Backend.hpp"
+
+namespace wiring {
+
+// Talks to the hardware through the GPIO character device and i2c-dev, so it does not need root or a sampling thread.
+// All of the used lines are held in a single line request so bulk reads and writes are one ioctl each.
+// Edges are read from the request by a thread that only wakes when the kernel has an event.
+// The character device has no PWM, so PWM and servo pins are not supported.
+class GpiochipBackend : public Backend {
+public:
+    static constexpr int NUM_PINS = 54;
+
+    explicit GpiochipBackend(std::string_view path = "/dev/gpiochip0");
+    ~GpiochipBackend() override;
+
+    void initialise() override;
+    void terminate() override;
+
+    void setMode(int pin, PinMode mode) override;
+
+    using Backend::write;
+    using Backend::read;
+    void write(int pin, bool level) override;
+    bool read(int pin) override;
+    void write(uint64_t mask, uint64_t levels) override;
+    uint64_t read(uint64_t mask) override;
+
+    void setAlert(int pin, Alert alert) override;
+
+    // Uses the line debounce, which the kernel does in software if the chip cannot.
+    void setGlitchFilter(int pin, Clock::duration steady) override;
+
+    void setPwmRange(int pin, int range) override;
+    int pwmRange(int pin) override;
+    void setPwmFrequency(int pin, int freq) override;
+    void pwm(int pin, int duty) override;
+
+    void servo(int pin, int pulseWidth) override;
+
+    unsigned i2cOpen(unsigned bus, uint8_t address) override;
+    void i2cClose(unsigned handle) override;
+
+    void i2cWriteByte(unsigned handle, uint8_t reg, uint8_t data) override;
+    uint8_t i2cReadByte(unsigned handle, uint8_t reg) override;
+
+    void i2cWriteWord(unsigned handle, uint8_t reg, uint16_t data) override;
+    uint16_t i2cReadWord(unsigned handle, uint8_t reg) override;
+
+    void i2cWriteBlock(unsigned handle, uint8_t reg, std::span<const uint8_t> data) override;
+    void i2cReadBlock(unsigned handle, uint8_t reg, std::span<uint8_t> data) override;
+
+private:
+    // Releases the current line request and requests every used line again with its current mode.
+    void request();
+    void release();
+
+    // Converts between pin masks and masks of the lines in the request.
+    uint64_t toLines(uint64_t mask) const;
+    uint64_t toPins(uint64_t lines) const;
+
+    void checkPin(int pin) const;
+    int i2cFd(unsigned handle) const;
+    void smbus(unsigned handle, uint8_t readWrite, uint8_t reg, int size, void* data) const;
+
+    void listen();
+
+    const std::string m_path;
+    int m_chip = -1;
+    int m_request = -1;
+    // Wakes the event thread to stop it.
+    int m_wake = -1;
+    std::thread m_thread;
+
+    std::array<PinMode, NUM_PINS> m_modes = {};
+    std::array<Alert, NUM_PINS> m_alerts = {};
+    // The debounce period of each pin in us.
+    std::array<uint32_t, NUM_PINS> m_debounce = {};
+    // The index of each pin in the request or -1.
+    std::array<int, NUM_PINS> m_lines;
+    // The pin of each line in the request.
+    std::vector<int> m_pins;
+    // Emergency stops and pings write outputs from other threads than the tick, so the outputs and their levels
+    // are only touched under this.
+    std::mutex m_outputMutex;
+    uint64_t m_outputs = 0;
+    // The last level written to each output, kept so it survives a new request.
+    uint64_t m_levels = 0;
+
+    // Indexed by handle, -1 once closed.
+    std::vector<int> m_i2cFds;
+    std::vector<uint8_t> m_i2cAddresses;
+};
+
+} // namespace wiring
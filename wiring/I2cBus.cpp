@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+#include "utils/Logger.hpp"
+
+#include "I2cBus.hpp"
+
+namespace wiring {
+
+std::mutex I2cBus::s_mutex;
+std::weak_ptr<I2cBus> I2cBus::s_bus;
+
+std::shared_ptr<I2cBus> I2cBus::get() {
+    const std::lock_guard lock(s_mutex);
+    auto bus = s_bus.lock();
+    if (bus == nullptr) {
+        bus = std::shared_ptr<I2cBus>(new I2cBus());
+        s_bus = bus;
+    }
+    return bus;
+}
+
+I2cBus::I2cBus() :
+    m_contextData(0),
+    m_contextClock(1),
+    m_backend(Backend::get())
+{}
+
+I2cBus::~I2cBus() {
+    {
+        const std::lock_guard lock(m_jobMutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    for (const auto& [address, handle] : m_muxHandles) {
+        m_backend.i2cClose(handle);
+    }
+}
+
+void I2cBus::add(uint8_t address, int channel) {
+    if (address >= m_muxed.size()) {
+        throw std::invalid_argument(std::format("wiring::I2cBus::add(): Not a 7 bit address: {:#04x}", address));
+    }
+    const std::lock_guard lock(m_mutex);
+    // Whenever a channel is open, a device behind it and one wired straight to the bus would both answer.
+    if (channel == NO_CHANNEL ? m_muxed[address] > 0 : m_direct[address] > 0) {
+        throw std::invalid_argument(std::format("wiring::I2cBus::add(): {:#04x} is used both on the bus and behind a mux", address));
+    }
+    auto& count = channel == NO_CHANNEL ? m_direct[address] : m_muxed[address];
+    count++;
+}
+
+void I2cBus::remove(uint8_t address, int channel) {
+    const std::lock_guard lock(m_mutex);
+    auto& count = channel == NO_CHANNEL ? m_direct[address] : m_muxed[address];
+    count--;
+}
+
+std::unique_lock<std::mutex> I2cBus::acquire(uint8_t address, int channel, uint8_t mux) {
+    std::unique_lock lock(m_mutex);
+    select(address, channel, mux);
+    m_counters.transactions++;
+    return lock;
+}
+
+void I2cBus::select(uint8_t address, int channel, uint8_t mux) {
+    // add() keeps the addresses on the bus and behind the muxes apart, so the open channel can stay open.
+    if (channel == NO_CHANNEL) {
+        return;
+    }
+    if (mux == m_mux && channel == m_channel) {
+        return;
+    }
+    if (channel < 0 || size_t(channel) >= MUX_CHANNELS) {
+        throw std::invalid_argument(std::format("wiring::I2cBus::select(): Channel not 0-{}: {}", MUX_CHANNELS - 1, channel));
+    }
+
+    auto it = m_muxHandles.find(mux);
+    if (it == m_muxHandles.end()) {
+        it = m_muxHandles.emplace(mux, m_backend.i2cOpen(BUS, mux)).first;
+    }
+
+    // Close the other mux first, or devices behind both would answer at once.
+    if (m_channel != NO_CHANNEL && m_mux != mux) {
+        closeMux();
+    }
+
+    // The TCA9548A has no registers and keeps the last byte written, so the "register" is the channel mask too.
+    const uint8_t mask = 1 << channel;
+    m_backend.i2cWriteByte(it->second, mask, mask);
+    m_mux = mux;
+    m_channel = channel;
+    m_counters.switches++;
+}
+
+void I2cBus::closeMux() {
+    m_backend.i2cWriteByte(m_muxHandles.at(m_mux), 0, 0);
+    m_channel = NO_CHANNEL;
+    m_counters.switches++;
+}
+
+I2cBus::JobId I2cBus::schedule(Clock::duration period, uint8_t mux, int channel, Job job) {
+    if (period <= Clock::duration::zero()) {
+        throw std::invalid_argument("wiring::I2cBus::schedule(): The period must be positive");
+    }
+
+    JobId id;
+    {
+        const std::lock_guard lock(m_jobMutex);
+        id = m_nextId++;
+        m_jobs.push_back({id, period, Clock::now(), mux, channel, std::move(job)});
+        if (!m_thread.joinable()) {
+            m_thread = std::thread(&I2cBus::run, this);
+        }
+    }
+    m_wake.notify_one();
+    return id;
+}
+
+void I2cBus::unschedule(JobId id) {
+    // The scheduler holds the lock while jobs run, so once it is taken the job is not running.
+    const std::lock_guard lock(m_jobMutex);
+    std::erase_if(m_jobs, [id](const Scheduled& job) { return job.id == id; });
+}
+
+I2cBus::Counters I2cBus::counters() const {
+    Counters counters;
+    {
+        const std::lock_guard lock(m_mutex);
+        counters.transactions = m_counters.transactions;
+        counters.switches = m_counters.switches;
+    }
+    const std::lock_guard lock(m_jobMutex);
+    counters.passes = m_counters.passes;
+    counters.jobs = m_counters.jobs;
+    return counters;
+}
+
+void I2cBus::run() {
+    std::vector<Scheduled*> due;
+    std::unique_lock lock(m_jobMutex);
+    while (!m_stop) {
+        const auto now = Clock::now();
+        auto next = Clock::time_point::max();
+        due.clear();
+        for (auto& job : m_jobs) {
+            if (job.due <= now) {
+                due.push_back(&job);
+            }
+            else {
+                next = std::min(next, job.due);
+            }
+        }
+
+        if (due.empty()) {
+            if (next == Clock::time_point::max()) {
+                m_wake.wait(lock);
+            }
+            else {
+                m_wake.wait_for(lock, next - now);
+            }
+            continue;
+        }
+
+        std::sort(due.begin(), due.end(), [](const Scheduled* a, const Scheduled* b) {
+            return std::pair(a->mux, a->channel) < std::pair(b->mux, b->channel);
+        });
+        for (auto* job : due) {
+            try {
+                job->job();
+            }
+            catch (const std::exception& e) {
+                logger.warning() << "wiring::I2cBus::run(): Job failed: " << e.what();
+            }
+            // A job that fell behind skips the periods it missed rather than running back to back.
+            job->due = std::max(job->due + job->period, now);
+        }
+        m_counters.passes++;
+        m_counters.jobs += due.size();
+    }
+}
+
+} // namespace wiring
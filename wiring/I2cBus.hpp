@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "utils/Clock.hpp"
+#include "utils/Function.hpp"
+
+#include "Backend.hpp"
+#include "Context.hpp"
+
+namespace wiring {
+
+// The I2C bus, shared by every device on it including those behind TCA9548A muxes.
+// Transactions from any thread are serialized and a mux is only switched when the next device is on another channel.
+// An address is either wired straight to the bus or behind muxes, never both, as both would answer while a channel is open.
+// A scheduler thread runs the periodic jobs of every device, such as FIFO drains,
+// so they are done in one pass per wake up, ordered by channel to keep the switches down.
+class I2cBus {
+public:
+    static constexpr unsigned BUS = 1;
+    static constexpr uint8_t MUX_ADDRESS = 0x70;
+    static constexpr size_t MUX_CHANNELS = 8;
+    // For devices wired straight to the bus.
+    static constexpr int NO_CHANNEL = -1;
+
+    using Job = Function<void()>;
+    using JobId = size_t;
+
+    struct Counters {
+        size_t transactions = 0;
+        size_t switches = 0;
+        // Scheduler wake ups and the jobs run in them.
+        size_t passes = 0;
+        size_t jobs = 0;
+    };
+
+    // The bus, which stays open while anything holds it.
+    static std::shared_ptr<I2cBus> get();
+
+    ~I2cBus();
+
+    I2cBus(const I2cBus&) = delete;
+    I2cBus& operator=(const I2cBus&) = delete;
+
+    Backend& backend() const { return m_backend; }
+
+    // Every device on the bus is added while it exists, so the bus knows which addresses are behind a mux.
+    // Throws if the address is already used on the other side of a mux.
+    void add(uint8_t address, int channel);
+    void remove(uint8_t address, int channel);
+
+    // Locks the bus and makes the device at address reachable, switching the mux at mux to channel if it is behind one.
+    // Everything done with the backend while the lock is held happens without other transactions in between.
+    [[nodiscard]] std::unique_lock<std::mutex> acquire(uint8_t address, int channel, uint8_t mux = MUX_ADDRESS);
+
+    // Runs job every period on the scheduler thread until it is unscheduled.
+    // Jobs run with the scheduler locked, so they must not schedule or unschedule jobs themselves.
+    JobId schedule(Clock::duration period, uint8_t mux, int channel, Job job);
+
+    // Removes a job, waiting for it to finish if it is running.
+    void unschedule(JobId id);
+
+    Counters counters() const;
+
+private:
+    struct Scheduled {
+        JobId id;
+        Clock::duration period;
+        Clock::time_point due;
+        uint8_t mux;
+        int channel;
+        Job job;
+    };
+
+    I2cBus();
+
+    // Must be called with the bus locked.
+    void select(uint8_t address, int channel, uint8_t mux);
+    void closeMux();
+
+    void run();
+
+    const Context m_contextData;
+    const Context m_contextClock;
+    Backend& m_backend;
+
+    mutable std::mutex m_mutex;
+    // Opened on first use and indexed by address.
+    std::map<uint8_t, unsigned> m_muxHandles;
+    uint8_t m_mux = 0;
+    int m_channel = NO_CHANNEL;
+    // The number of devices wired straight to the bus and behind a mux at each 7 bit address.
+    std::array<uint8_t, 128> m_direct = {};
+    std::array<uint8_t, 128> m_muxed = {};
+    // The transactions and switches are guarded by m_mutex, the passes and jobs by m_jobMutex.
+    Counters m_counters;
+
+    mutable std::mutex m_jobMutex;
+    std::condition_variable m_wake;
+    std::vector<Scheduled> m_jobs;
+    JobId m_nextId = 0;
+    bool m_stop = false;
+    std::thread m_thread;
+
+    static std::mutex s_mutex;
+    static std::weak_ptr<I2cBus> s_bus;
+};
+
+} // namespace wiring
@@ -1,31 +1,49 @@
+#include <array>
 #include <format>
+#include <stdexcept>
 #include <endian.h>
-#include <pigpio.h>
 
 #include "utils/Other.hpp"
-#include "utils/PigpioError.hpp"
 
 #include "I2cDevice.hpp"
 
 namespace wiring {
 
-static constexpr unsigned I2C_BUS = 1;
+static unsigned open(I2cBus& bus, uint8_t address, int channel, uint8_t mux) {
+    bus.add(address, channel);
+    try {
+        const auto lock = bus.acquire(address, channel, mux);
+        return bus.backend().i2cOpen(I2cBus::BUS, address);
+    }
+    catch (...) {
+        // The destructor never runs, so nothing else would take the device off the bus.
+        bus.remove(address, channel);
+        throw;
+    }
+}
 
-I2cDevice::I2cDevice(uint8_t address, bool bigEndian) : 
-    m_contextData(0),
-    m_contextClock(1),
-    m_handle(pigpio::checkError(i2cOpen(I2C_BUS, address, 0))),
-    m_bigEndian(bigEndian)
+I2cDevice::I2cDevice(uint8_t address, bool bigEndian, int channel, uint8_t mux) : 
+    m_bus(I2cBus::get()),
+    m_backend(m_bus->backend()),
+    m_handle(open(*m_bus, address, channel, mux)),
+    m_bigEndian(bigEndian),
+    m_address(address),
+    m_channel(channel),
+    m_mux(mux)
 {}
 
 I2cDevice::~I2cDevice() {
-    i2cClose(m_handle);
+    {
+        const auto lock = m_bus->acquire(m_address, m_channel, m_mux);
+        m_backend.i2cClose(m_handle);
+    }
+    m_bus->remove(m_address, m_channel);
 }
 
 template <>
 void I2cDevice::write(int reg, uint8_t data) const {
-    const auto ret = i2cWriteByteData(m_handle, reg, data);
-    pigpio::checkError(ret);
+    const auto lock = m_bus->acquire(m_address, m_channel, m_mux);
+    m_backend.i2cWriteByte(m_handle, reg, data);
 }
 
 template <>
@@ -37,22 +55,20 @@ void I2cDevice::write(int reg, int16_t data) const {
         data = htole16(data);
     }
 
-    const auto ret = i2cWriteWordData(m_handle, reg, data);
-    pigpio::checkError(ret);
+    const auto lock = m_bus->acquire(m_address, m_channel, m_mux);
+    m_backend.i2cWriteWord(m_handle, reg, data);
 }
 
 template <>
 uint8_t I2cDevice::read(int reg) const {
-    const auto ret = i2cReadByteData(m_handle, reg);
-    return pigpio::checkError(ret);
+    const auto lock = m_bus->acquire(m_address, m_channel, m_mux);
+    return m_backend.i2cReadByte(m_handle, reg);
 }
 
 template <>
 int16_t I2cDevice::read(int reg) const {
-    const auto ret = i2cReadWordData(m_handle, reg);
-    pigpio::checkError(ret);
-
-    int16_t data = ret;
+    const auto lock = m_bus->acquire(m_address, m_channel, m_mux);
+    int16_t data = m_backend.i2cReadWord(m_handle, reg);
     
     if (m_bigEndian) {
         data = be16toh(data);
@@ -64,5 +80,44 @@ int16_t I2cDevice::read(int reg) const {
     return data;
 }
 
+template <>
+void I2cDevice::write(int reg, std::span<const uint8_t> data) const {
+    const auto lock = m_bus->acquire(m_address, m_channel, m_mux);
+    m_backend.i2cWriteBlock(m_handle, reg, data);
+}
+
+template <>
+void I2cDevice::read(int reg, std::span<uint8_t> data) const {
+    const auto lock = m_bus->acquire(m_address, m_channel, m_mux);
+    m_backend.i2cReadBlock(m_handle, reg, data);
+}
+
+template <>
+void I2cDevice::write(int reg, std::span<const int16_t> data) const {
+    constexpr size_t MAX_WORDS = 32;
+    if (data.size() > MAX_WORDS) {
+        throw std::invalid_argument(std::format("wiring::I2cDevice::write(): Blocks are at most {} words", MAX_WORDS));
+    }
+    std::array<uint8_t, 2 * MAX_WORDS> bytes;
+    for (size_t i = 0; i < data.size(); i++) {
+        const auto word = uint16_t(data[i]);
+        bytes[2 * i + (m_bigEndian ? 0 : 1)] = word >> 8;
+        bytes[2 * i + (m_bigEndian ? 1 : 0)] = word & 0xFF;
+    }
+    const auto lock = m_bus->acquire(m_address, m_channel, m_mux);
+    m_backend.i2cWriteBlock(m_handle, reg, std::span(bytes.data(), 2 * data.size()));
+}
+
+template <>
+void I2cDevice::read(int reg, std::span<int16_t> data) const {
+    // Read the bytes straight into the words and fix their order in place.
+    const auto bytes = std::as_writable_bytes(data);
+    const auto lock = m_bus->acquire(m_address, m_channel, m_mux);
+    m_backend.i2cReadBlock(m_handle, reg, std::span(reinterpret_cast<uint8_t*>(bytes.data()), bytes.size()));
+    for (auto& value : data) {
+        value = m_bigEndian ? int16_t(be16toh(uint16_t(value))) : int16_t(le16toh(uint16_t(value)));
+    }
+}
+
 } // namespace wiring
 
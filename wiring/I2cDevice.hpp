@@ -1,27 +1,47 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <span>
 
-#include "Context.hpp"
+#include "Backend.hpp"
+#include "I2cBus.hpp"
 
 namespace wiring {
 
+// A device on the shared I2C bus. Every call is one transaction, serialized with those of every other device.
+// Devices behind a TCA9548A give its channel and address, and the mux is switched to them as needed.
 class I2cDevice {
 public:
-    I2cDevice(uint8_t address, bool bigEndian = false);
+    I2cDevice(uint8_t address, bool bigEndian = false, int channel = I2cBus::NO_CHANNEL, uint8_t mux = I2cBus::MUX_ADDRESS);
     ~I2cDevice();
 
+    I2cBus& bus() const { return *m_bus; }
+    int channel() const { return m_channel; }
+    uint8_t mux() const { return m_mux; }
+
     template <typename T>
     void write(int reg, T data) const;
 
     template <typename T>
     T read(int reg) const;
 
+    // Writes or reads consecutive registers starting at reg in a single transaction.
+    // Multi-byte values are converted from the device byte order.
+    template <typename T>
+    void write(int reg, std::span<const T> data) const;
+
+    template <typename T>
+    void read(int reg, std::span<T> data) const;
+
 private:
-    const Context m_contextData;
-    const Context m_contextClock;
+    const std::shared_ptr<I2cBus> m_bus;
+    Backend& m_backend;
     const unsigned m_handle;
     const bool m_bigEndian;
+    const uint8_t m_address;
+    const int m_channel;
+    const uint8_t m_mux;
 };
 
 } // namespace wiring
@@ -0,0 +1,224 @@
+#include <cmath>
+#include <numbers>
+#include <thread>
+
+#include "Mpu6050Model.hpp"
+
+namespace wiring {
+
+constexpr uint8_t SLEEP = 0x40;
+constexpr uint8_t RESET = 0x80;
+constexpr uint8_t FIFO_ENABLE = 0x40;
+constexpr uint8_t FIFO_RESET = 0x04;
+constexpr uint8_t FIFO_OFLOW = 0x10;
+constexpr uint8_t DATA_RDY = 0x01;
+constexpr uint8_t DATA_RDY_EN = 0x01;
+constexpr auto INTERRUPT_IDLE = std::chrono::milliseconds(10);
+constexpr uint8_t TEMP_FIFO = 0x80;
+constexpr uint8_t ACCEL_FIFO = 0x08;
+constexpr float GYRO_LSB = 131.0f;
+constexpr float ACCEL_LSB = 16384.0f;
+constexpr float ROCK_AMPLITUDE = 30.0f;
+constexpr float ROCK_FREQ = 0.5f;
+constexpr float TEMPERATURE = 25.0f;
+
+Mpu6050Model::Mpu6050Model(Interrupt interrupt) :
+    m_interrupt(std::move(interrupt))
+{
+    reset();
+}
+
+Mpu6050Model::~Mpu6050Model() {
+    if (m_thread.joinable()) {
+        m_stop.store(true, std::memory_order_relaxed);
+        m_thread.join();
+    }
+}
+
+void Mpu6050Model::reset() {
+    m_registers = {};
+    m_registers[PWR_MGMT_1] = SLEEP;
+    m_registers[WHO_AM_I] = ADDRESS;
+    m_fifoHead = 0;
+    m_fifoSize = 0;
+}
+
+uint8_t Mpu6050Model::read(uint8_t reg) {
+    if (reg >= ACCEL_XOUT_H && reg <= GYRO_ZOUT_L) {
+        sample();
+    }
+
+    switch (reg) {
+    case INT_STATUS: {
+        fill();
+        // Reading the status clears it.
+        const auto status = m_registers[INT_STATUS];
+        m_registers[INT_STATUS] = 0;
+        return status;
+    }
+    case FIFO_COUNT_H:
+        fill();
+        return m_fifoSize >> 8;
+    case FIFO_COUNT_L:
+        return m_fifoSize & 0xFF;
+    case FIFO_R_W: {
+        if (m_fifoSize == 0) {
+            return 0;
+        }
+        const auto byte = m_fifo[m_fifoHead];
+        m_fifoHead = (m_fifoHead + 1) % FIFO_SIZE;
+        m_fifoSize--;
+        return byte;
+    }
+    default:
+        return m_registers[reg];
+    }
+}
+
+void Mpu6050Model::write(uint8_t reg, uint8_t data) {
+    switch (reg) {
+    case WHO_AM_I:
+    case INT_STATUS:
+        return;
+    case PWR_MGMT_1:
+        if ((data & RESET) != 0) {
+            reset();
+            updateInterrupt();
+            return;
+        }
+        break;
+    case USER_CTRL:
+        if ((data & FIFO_RESET) != 0) {
+            m_fifoHead = 0;
+            m_fifoSize = 0;
+            data &= ~FIFO_RESET;
+        }
+        // Samples start going into the FIFO from when it is enabled.
+        if ((data & FIFO_ENABLE) != 0 && (m_registers[USER_CTRL] & FIFO_ENABLE) == 0) {
+            m_lastFifo = Clock::now();
+        }
+        break;
+    default:
+        break;
+    }
+    m_registers[reg] = data;
+    updateInterrupt();
+}
+
+Clock::duration Mpu6050Model::period() const {
+    // The gyro runs at 8 kHz without the low pass filter and 1 kHz with it.
+    const auto rate = (m_registers[CONFIG] & 0x7) == 0 ? 8000 : 1000;
+    return std::chrono::nanoseconds(1'000'000'000LL * (1 + m_registers[SMPLRT_DIV]) / rate);
+}
+
+Mpu6050Model::Measurement Mpu6050Model::measure(Clock::time_point time) const {
+    const auto gyroScale = GYRO_LSB / float(1 << ((m_registers[GYRO_CONFIG] >> 3) & 0x3));
+    const auto accelScale = ACCEL_LSB / float(1 << ((m_registers[ACCEL_CONFIG] >> 3) & 0x3));
+    const auto t = std::chrono::duration<float>(time.time_since_epoch()).count();
+    const auto rotZ = ROCK_AMPLITUDE * std::sin(2.0f * std::numbers::pi_v<float> * ROCK_FREQ * t);
+
+    return {
+        0, 0, int16_t(accelScale),
+        int16_t((TEMPERATURE - 36.53f) * 340.0f),
+        0, 0, int16_t(rotZ * gyroScale)
+    };
+}
+
+void Mpu6050Model::set(uint8_t reg, int16_t value) {
+    m_registers[reg] = uint16_t(value) >> 8;
+    m_registers[reg + 1] = uint16_t(value) & 0xFF;
+}
+
+void Mpu6050Model::sample() {
+    // The measurements hold still while asleep.
+    if ((m_registers[PWR_MGMT_1] & SLEEP) != 0) {
+        return;
+    }
+
+    const auto now = Clock::now();
+    if (now - m_lastSample < period()) {
+        return;
+    }
+    m_lastSample = now;
+
+    const auto measurement = measure(now);
+    for (size_t i = 0; i < measurement.size(); i++) {
+        set(ACCEL_XOUT_H + 2 * i, measurement[i]);
+    }
+}
+
+void Mpu6050Model::updateInterrupt() {
+    const bool enabled = m_interrupt && (m_registers[PWR_MGMT_1] & SLEEP) == 0 && (m_registers[INT_ENABLE] & DATA_RDY_EN) != 0;
+    m_interruptPeriod.store(enabled ? period().count() : 0, std::memory_order_relaxed);
+
+    // The thread is only started once something asks for interrupts and then lives as long as the model.
+    if (enabled && !m_thread.joinable()) {
+        m_thread = std::thread(&Mpu6050Model::pulse, this);
+    }
+}
+
+void Mpu6050Model::pulse() {
+    auto next = std::chrono::steady_clock::now();
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        const auto period = Clock::duration(m_interruptPeriod.load(std::memory_order_relaxed));
+        if (period == Clock::duration::zero()) {
+            std::this_thread::sleep_for(INTERRUPT_IDLE);
+            next = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        next += period;
+        std::this_thread::sleep_until(next);
+        // The sensor pulses INT high for 50 us by default, which is instant as far as the simulation goes.
+        m_interrupt(true);
+        m_interrupt(false);
+    }
+}
+
+void Mpu6050Model::push(uint8_t byte) {
+    // A full FIFO loses its oldest data.
+    if (m_fifoSize == FIFO_SIZE) {
+        m_fifoHead = (m_fifoHead + 1) % FIFO_SIZE;
+        m_fifoSize--;
+        m_registers[INT_STATUS] |= FIFO_OFLOW;
+    }
+    m_fifo[(m_fifoHead + m_fifoSize) % FIFO_SIZE] = byte;
+    m_fifoSize++;
+}
+
+void Mpu6050Model::fill() {
+    if ((m_registers[PWR_MGMT_1] & SLEEP) != 0 || (m_registers[USER_CTRL] & FIFO_ENABLE) == 0) {
+        return;
+    }
+
+    const auto step = period();
+    const auto now = Clock::now();
+    const auto enabled = m_registers[FIFO_EN];
+    if (now - m_lastFifo >= step) {
+        m_registers[INT_STATUS] |= DATA_RDY;
+    }
+
+    // Anything older than a full FIFO would be lost anyway.
+    const auto due = (now - m_lastFifo) / step;
+    if (due > Clock::duration::rep(FIFO_SIZE)) {
+        m_lastFifo += (due - FIFO_SIZE) * step;
+        m_registers[INT_STATUS] |= FIFO_OFLOW;
+    }
+
+    for (; now - m_lastFifo >= step; m_lastFifo += step) {
+        const auto measurement = measure(m_lastFifo + step);
+        // The FIFO is filled in register order: accel, temperature, then each gyro axis.
+        for (size_t i = 0; i < measurement.size(); i++) {
+            const bool include =
+                i < 3 ? (enabled & ACCEL_FIFO) != 0 :
+                i == 3 ? (enabled & TEMP_FIFO) != 0 :
+                (enabled & (0x40 >> (i - 4))) != 0;
+            if (include) {
+                push(uint16_t(measurement[i]) >> 8);
+                push(uint16_t(measurement[i]) & 0xFF);
+            }
+        }
+    }
+}
+
+} // namespace wiring
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "utils/Clock.hpp"
+#include "utils/Function.hpp"
+
+#include "SimBackend.hpp"
+
+namespace wiring {
+
+// A simulated MPU-6050 that sits flat while slowly rocking about its Z axis.
+// The measurements are a function of the Clock, so they are reproducible when it is simulated.
+// The FIFO is filled at the sample rate whenever it is looked at.
+// With the data ready interrupt enabled, a thread pulses the INT pin once per sample.
+class Mpu6050Model : public RegisterModel {
+public:
+    static constexpr uint8_t ADDRESS = 0x68;
+    // With AD0 pulled high.
+    static constexpr uint8_t ALT_ADDRESS = 0x69;
+
+    static constexpr uint8_t SMPLRT_DIV   = 0x19;
+    static constexpr uint8_t CONFIG       = 0x1A;
+    static constexpr uint8_t GYRO_CONFIG  = 0x1B;
+    static constexpr uint8_t ACCEL_CONFIG = 0x1C;
+    static constexpr uint8_t FIFO_EN      = 0x23;
+    static constexpr uint8_t INT_PIN_CFG  = 0x37;
+    static constexpr uint8_t INT_ENABLE   = 0x38;
+    static constexpr uint8_t INT_STATUS   = 0x3A;
+    static constexpr uint8_t ACCEL_XOUT_H = 0x3B;
+    static constexpr uint8_t TEMP_OUT_H   = 0x41;
+    static constexpr uint8_t GYRO_XOUT_H  = 0x43;
+    static constexpr uint8_t GYRO_ZOUT_L  = 0x48;
+    static constexpr uint8_t USER_CTRL    = 0x6A;
+    static constexpr uint8_t PWR_MGMT_1   = 0x6B;
+    static constexpr uint8_t FIFO_COUNT_H = 0x72;
+    static constexpr uint8_t FIFO_COUNT_L = 0x73;
+    static constexpr uint8_t FIFO_R_W     = 0x74;
+    static constexpr uint8_t WHO_AM_I     = 0x75;
+
+    static constexpr size_t FIFO_SIZE = 1024;
+
+    using Interrupt = Function<void(bool level)>;
+
+    // interrupt drives whatever the INT pin is wired to.
+    Mpu6050Model(Interrupt interrupt = nullptr);
+    ~Mpu6050Model() override;
+
+    uint8_t read(uint8_t reg) override;
+    void write(uint8_t reg, uint8_t data) override;
+
+    // Bursts from the FIFO keep reading the FIFO.
+    uint8_t next(uint8_t reg) const override { return reg == FIFO_R_W ? reg : reg + 1; }
+
+private:
+    // Accel X, Y, Z, temperature, then gyro X, Y, Z.
+    using Measurement = std::array<int16_t, 7>;
+
+    void reset();
+
+    Clock::duration period() const;
+    Measurement measure(Clock::time_point time) const;
+
+    // Refreshes the measurement registers once per sample period.
+    void sample();
+
+    // Adds every sample that is due to the FIFO.
+    void fill();
+    void push(uint8_t byte);
+
+    void set(uint8_t reg, int16_t value);
+
+    // Starts or stops the interrupt pulses to match the registers.
+    void updateInterrupt();
+    void pulse();
+
+    Clock::time_point m_lastSample;
+    Clock::time_point m_lastFifo;
+    std::array<uint8_t, FIFO_SIZE> m_fifo = {};
+    size_t m_fifoHead = 0;
+    size_t m_fifoSize = 0;
+
+    const Interrupt m_interrupt;
+    // The time between interrupt pulses in ns, 0 while they are off.
+    std::atomic<Clock::rep> m_interruptPeriod = 0;
+    std::atomic<bool> m_stop = false;
+    std::thread m_thread;
+};
+
+} // namespace wiring
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+#include <thread>
+
+#include "Pca9685.hpp"
+
+namespace wiring {
+
+constexpr int MODE1 = 0x00;
+constexpr int MODE2 = 0x01;
+constexpr int LED0_ON_L = 0x06;
+constexpr int ALL_LED_OFF_H = 0xFD;
+constexpr int PRE_SCALE = 0xFE;
+
+constexpr uint8_t RESTART = 0x80;
+constexpr uint8_t AUTO_INCREMENT = 0x20;
+constexpr uint8_t SLEEP = 0x10;
+constexpr uint8_t OUTDRV = 0x04;
+// Bit 4 of the ON_H or OFF_H register holds the channel fully on or off.
+constexpr uint8_t FULL = 0x10;
+constexpr size_t CHANNEL_BYTES = 4;
+
+constexpr float OSCILLATOR = 25'000'000.0f;
+// The oscillator takes this long to start after waking up.
+constexpr auto WAKE_TIME = std::chrono::microseconds(500);
+
+std::mutex Pca9685::s_mutex;
+std::map<uint8_t, std::weak_ptr<Pca9685>> Pca9685::s_chips;
+
+std::shared_ptr<Pca9685> Pca9685::get(uint8_t address) {
+    const std::lock_guard lock(s_mutex);
+    auto chip = s_chips[address].lock();
+    if (chip == nullptr) {
+        chip = std::shared_ptr<Pca9685>(new Pca9685(address, FREQUENCY));
+        s_chips[address] = chip;
+    }
+    return chip;
+}
+
+Pca9685::Pca9685(uint8_t address, int frequency) :
+    m_device(address)
+{
+    m_staged.fill(0);
+    m_applied.fill(UNKNOWN);
+
+    // The prescaler can only be set while asleep.
+    const auto prescale = std::clamp(int(std::lround(OSCILLATOR / (RESOLUTION * frequency))) - 1, 3, 255);
+    m_frequency = OSCILLATOR / (RESOLUTION * (prescale + 1));
+    m_device.write<uint8_t>(MODE1, SLEEP | AUTO_INCREMENT);
+    m_device.write<uint8_t>(PRE_SCALE, prescale);
+    m_device.write<uint8_t>(MODE2, OUTDRV);
+    m_device.write<uint8_t>(MODE1, AUTO_INCREMENT);
+    std::this_thread::sleep_for(WAKE_TIME);
+    m_device.write<uint8_t>(MODE1, RESTART | AUTO_INCREMENT);
+    m_device.write<uint8_t>(ALL_LED_OFF_H, FULL);
+
+    Bank::get().add(this);
+}
+
+Pca9685::~Pca9685() {
+    Bank::get().remove(this);
+
+    m_device.write<uint8_t>(ALL_LED_OFF_H, FULL);
+    m_device.write<uint8_t>(MODE1, SLEEP);
+}
+
+std::array<uint8_t, 4> Pca9685::encode(int ticks) {
+    if (ticks <= 0) {
+        return {0, 0, 0, FULL};
+    }
+    if (ticks >= RESOLUTION) {
+        return {0, FULL, 0, 0};
+    }
+    // On at tick 0 and off after ticks.
+    return {0, 0, uint8_t(ticks & 0xFF), uint8_t(ticks >> 8)};
+}
+
+void Pca9685::stage(int channel, int ticks) {
+    if (channel < 0 || channel >= NUM_CHANNELS) {
+        throw std::invalid_argument(std::format("wiring::Pca9685::stage(): Channel is out of range 0-{}: {}", NUM_CHANNELS - 1, channel));
+    }
+    const std::lock_guard lock(m_mutex);
+    m_counters.writes++;
+    m_staged[channel] = std::clamp(ticks, 0, RESOLUTION);
+}
+
+void Pca9685::halt(int channel, int ticks) {
+    ticks = std::clamp(ticks, 0, RESOLUTION);
+    const auto bytes = encode(ticks);
+    const std::lock_guard lock(m_mutex);
+    m_device.write<uint8_t>(LED0_ON_L + CHANNEL_BYTES * channel, std::span<const uint8_t>(bytes));
+    m_applied[channel] = ticks;
+}
+
+void Pca9685::commit() {
+    const std::lock_guard lock(m_mutex);
+
+    int first = NUM_CHANNELS;
+    int last = -1;
+    for (int c = 0; c < NUM_CHANNELS; c++) {
+        if (m_staged[c] != m_applied[c]) {
+            first = std::min(first, c);
+            last = c;
+        }
+    }
+    if (last < 0) {
+        return;
+    }
+
+    // Unchanged channels between the changed ones are rewritten with what they already have, to keep it to one transaction.
+    std::array<uint8_t, NUM_CHANNELS * CHANNEL_BYTES> bytes;
+    const auto count = size_t(last - first + 1);
+    for (size_t i = 0; i < count; i++) {
+        const auto channel = bytes.data() + i * CHANNEL_BYTES;
+        const auto encoded = encode(m_staged[first + i]);
+        std::copy(encoded.begin(), encoded.end(), channel);
+    }
+    m_device.write<uint8_t>(LED0_ON_L + CHANNEL_BYTES * first, std::span<const uint8_t>(bytes.data(), count * CHANNEL_BYTES));
+
+    std::copy_n(m_staged.begin() + first, count, m_applied.begin() + first);
+    m_counters.transactions++;
+    m_counters.channels += count;
+}
+
+Pca9685::Counters Pca9685::counters() const {
+    const std::lock_guard lock(m_mutex);
+    return m_counters;
+}
+
+} // namespace wiring
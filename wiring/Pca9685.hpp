@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "Bank.hpp"
+#include "I2cDevice.hpp"
+
+namespace wiring {
+
+// A PCA9685 16 channel, 12 bit PWM expander on the I2C bus.
+// Channel writes are staged and committed with the Bank, so every channel that changed in a tick goes out
+// in one auto increment block from the first changed channel to the last, and a tick with no changes costs nothing.
+// Every channel shares the chip's frequency, which defaults to the 50 Hz that servos need.
+class Pca9685 : public StagedDevice {
+public:
+    static constexpr uint8_t ADDRESS = 0x40;
+    static constexpr int NUM_CHANNELS = 16;
+    // The ticks in each period.
+    static constexpr int RESOLUTION = 4096;
+    static constexpr int FREQUENCY = 50;
+
+    struct Counters {
+        // Channel writes staged by the pins.
+        uint64_t writes = 0;
+        // Block writes and the channels in them.
+        uint64_t transactions = 0;
+        uint64_t channels = 0;
+    };
+
+    // The chip at address, shared by every pin on it while any of them exist.
+    static std::shared_ptr<Pca9685> get(uint8_t address = ADDRESS);
+
+    ~Pca9685() override;
+
+    Pca9685(const Pca9685&) = delete;
+    Pca9685& operator=(const Pca9685&) = delete;
+
+    // The actual frequency, which the prescaler only gets close to the one asked for.
+    float frequency() const { return m_frequency; }
+
+    // ticks is how many of the RESOLUTION ticks of each period the channel is on.
+    void stage(int channel, int ticks);
+
+    // Writes the channel straight away instead of at the next commit. Safe to call from any thread.
+    void halt(int channel, int ticks);
+
+    void commit() override;
+
+    Counters counters() const;
+
+private:
+    static constexpr int UNKNOWN = -1;
+
+    Pca9685(uint8_t address, int frequency);
+
+    // The ON and OFF registers of a channel, using the full on and full off bits at either end of the range.
+    static std::array<uint8_t, 4> encode(int ticks);
+
+    const I2cDevice m_device;
+    float m_frequency;
+
+    mutable std::mutex m_mutex;
+    std::array<int, NUM_CHANNELS> m_staged;
+    std::array<int, NUM_CHANNELS> m_applied;
+    Counters m_counters;
+
+    static std::mutex s_mutex;
+    static std::map<uint8_t, std::weak_ptr<Pca9685>> s_chips;
+};
+
+} // namespace wiring
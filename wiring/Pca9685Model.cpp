@@ -0,0 +1,58 @@
+#include "Pca9685Model.hpp"
+
+namespace wiring {
+
+constexpr uint8_t MODE1 = 0x00;
+constexpr uint8_t LED0_ON_L = 0x06;
+constexpr uint8_t ALL_LED_ON_L = 0xFA;
+constexpr uint8_t PRE_SCALE = 0xFE;
+constexpr uint8_t AUTO_INCREMENT = 0x20;
+constexpr uint8_t SLEEP = 0x10;
+constexpr uint8_t FULL = 0x10;
+constexpr int RESOLUTION = 4096;
+constexpr float OSCILLATOR = 25'000'000.0f;
+
+void Pca9685Model::write(uint8_t reg, uint8_t data) {
+    m_writes++;
+    // The prescaler is only writable while asleep.
+    if (reg == PRE_SCALE && (m_registers[MODE1] & SLEEP) == 0) {
+        return;
+    }
+    // The ALL_LED registers load every channel.
+    if (reg >= ALL_LED_ON_L && reg < PRE_SCALE) {
+        for (int c = 0; c < NUM_CHANNELS; c++) {
+            m_registers[LED0_ON_L + 4 * c + reg - ALL_LED_ON_L] = data;
+        }
+    }
+    m_registers[reg] = data;
+}
+
+uint8_t Pca9685Model::next(uint8_t reg) const {
+    return (m_registers[MODE1] & AUTO_INCREMENT) != 0 ? reg + 1 : reg;
+}
+
+int Pca9685Model::ticks(int channel) const {
+    const auto* led = m_registers.data() + LED0_ON_L + 4 * channel;
+    // Full off wins over full on.
+    if ((led[3] & FULL) != 0) {
+        return 0;
+    }
+    if ((led[1] & FULL) != 0) {
+        return RESOLUTION;
+    }
+    const int on = led[0] | ((led[1] & 0xF) << 8);
+    const int off = led[2] | ((led[3] & 0xF) << 8);
+    return (off - on + RESOLUTION) % RESOLUTION;
+}
+
+float Pca9685Model::frequency() const {
+    // Reset leaves the prescaler at 30, about 200 Hz.
+    const int prescale = m_registers[PRE_SCALE] == 0 ? 30 : m_registers[PRE_SCALE];
+    return OSCILLATOR / (RESOLUTION * (prescale + 1));
+}
+
+float Pca9685Model::pulseWidth(int channel) const {
+    return ticks(channel) * 1e6f / (frequency() * RESOLUTION);
+}
+
+} // namespace wiring
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#include "SimBackend.hpp"
+
+namespace wiring {
+
+// A simulated PCA9685 that keeps its channel registers so the outputs can be checked.
+// Auto increment is honoured, so a block write lands on consecutive channels only when it is on.
+class Pca9685Model : public RegisterModel {
+public:
+    static constexpr uint8_t ADDRESS = 0x40;
+    static constexpr int NUM_CHANNELS = 16;
+
+    void write(uint8_t reg, uint8_t data) override;
+
+    uint8_t next(uint8_t reg) const override;
+
+    // The ticks of each period the channel is on, from 0 to 4096.
+    int ticks(int channel) const;
+    float frequency() const;
+    // The pulse width in us.
+    float pulseWidth(int channel) const;
+
+    // Register writes, which block writes make one per byte.
+    size_t writes() const { return m_writes; }
+
+private:
+    size_t m_writes = 0;
+};
+
+} // namespace wiring
@@ -0,0 +1,200 @@
+#ifdef RAPPY_PIGPIO
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+#include <pigpio.h>
+
+#include "utils/Other.hpp"
+#include "utils/PigpioError.hpp"
+
+#include "PigpioBackend.hpp"
+
+namespace wiring {
+
+constexpr size_t SMBUS_BLOCK_MAX = 32;
+
+void PigpioBackend::initialise() {
+    pigpio::checkError(gpioInitialise());
+}
+
+void PigpioBackend::terminate() {
+    gpioTerminate();
+}
+
+void PigpioBackend::setMode(int pin, PinMode mode) {
+    unsigned pigpioMode;
+    switch (mode) {
+    case PinMode::IN:  pigpioMode = PI_INPUT; break;
+    case PinMode::OUT: pigpioMode = PI_OUTPUT; break;
+    case PinMode::PWM:
+    case PinMode::SERVO: pigpioMode = PI_ALT5; break;
+    default: throw std::logic_error(std::format("Unexpected pin mode: {}", to_underlying(mode)));
+    }
+    pigpio::checkError(gpioSetMode(pin, pigpioMode));
+}
+
+void PigpioBackend::write(int pin, bool level) {
+    const std::lock_guard lock(m_outputMutex);
+    pigpio::checkError(gpioWrite(pin, level ? PI_HIGH : PI_LOW));
+}
+
+void PigpioBackend::write(uint64_t mask, uint64_t levels) {
+    const uint64_t set = mask & levels;
+    const uint64_t clear = mask & ~levels;
+    const std::lock_guard lock(m_outputMutex);
+    if (uint32_t(set) != 0) {
+        pigpio::checkError(gpioWrite_Bits_0_31_Set(uint32_t(set)));
+    }
+    if (uint32_t(clear) != 0) {
+        pigpio::checkError(gpioWrite_Bits_0_31_Clear(uint32_t(clear)));
+    }
+    if ((set >> 32) != 0) {
+        pigpio::checkError(gpioWrite_Bits_32_53_Set(uint32_t(set >> 32)));
+    }
+    if ((clear >> 32) != 0) {
+        pigpio::checkError(gpioWrite_Bits_32_53_Clear(uint32_t(clear >> 32)));
+    }
+}
+
+uint64_t PigpioBackend::read(uint64_t mask) {
+    uint64_t levels = 0;
+    if (uint32_t(mask) != 0) {
+        levels |= gpioRead_Bits_0_31();
+    }
+    if ((mask >> 32) != 0) {
+        levels |= uint64_t(gpioRead_Bits_32_53()) << 32;
+    }
+    return levels & mask;
+}
+
+bool PigpioBackend::read(int pin) {
+    return pigpio::checkError(gpioRead(pin)) == PI_HIGH;
+}
+
+void PigpioBackend::setAlert(int pin, Alert alert) {
+    if (pin < 0 || pin >= NUM_PINS) {
+        throw std::invalid_argument(std::format("wiring::PigpioBackend::setAlert(): Pin is out of range 0-{}: {}", NUM_PINS - 1, pin));
+    }
+    // Unhook first so the pigpio thread never sees a half assigned alert.
+    pigpio::checkError(gpioSetAlertFuncEx(pin, nullptr, nullptr));
+    m_alerts[pin] = std::move(alert);
+    if (!m_alerts[pin]) {
+        return;
+    }
+
+    const auto callback = [](int gpio, int level, uint32_t tick, void* data) {
+        // Level 2 is a watchdog timeout rather than an edge.
+        if (level == PI_TIMEOUT) {
+            return;
+        }
+        // Ticks are us since boot that wrap, so turn them into a time by their age.
+        const auto age = std::chrono::microseconds(gpioTick() - tick);
+        (*static_cast<const Alert*>(data))(gpio, level == PI_HIGH, Clock::now() - age);
+    };
+    pigpio::checkError(gpioSetAlertFuncEx(pin, callback, &m_alerts[pin]));
+}
+
+void PigpioBackend::setGlitchFilter(int pin, Clock::duration steady) {
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(steady).count();
+    pigpio::checkError(gpioGlitchFilter(pin, us));
+}
+
+void PigpioBackend::setPwmRange(int pin, int range) {
+    pigpio::checkError(gpioSetPWMrange(pin, range));
+}
+
+int PigpioBackend::pwmRange(int pin) {
+    return pigpio::checkError(gpioGetPWMrange(pin));
+}
+
+void PigpioBackend::setPwmFrequency(int pin, int freq) {
+    pigpio::checkError(gpioSetPWMfrequency(pin, freq));
+}
+
+void PigpioBackend::pwm(int pin, int duty) {
+    const std::lock_guard lock(m_outputMutex);
+    pigpio::checkError(gpioPWM(pin, duty));
+}
+
+void PigpioBackend::trigger(int pin, Clock::duration pulse, bool level) {
+    constexpr auto MAX_TRIGGER = std::chrono::microseconds(100);
+    if (pulse > MAX_TRIGGER) {
+        Backend::trigger(pin, pulse, level);
+        return;
+    }
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(pulse).count();
+    const std::lock_guard lock(m_outputMutex);
+    pigpio::checkError(gpioTrigger(pin, unsigned(std::max<int64_t>(us, 1)), level ? PI_HIGH : PI_LOW));
+}
+
+void PigpioBackend::servo(int pin, int pulseWidth) {
+    const std::lock_guard lock(m_outputMutex);
+    pigpio::checkError(gpioServo(pin, pulseWidth));
+}
+
+unsigned PigpioBackend::i2cOpen(unsigned bus, uint8_t address) {
+    return pigpio::checkError(::i2cOpen(bus, address, 0));
+}
+
+void PigpioBackend::i2cClose(unsigned handle) {
+    ::i2cClose(handle);
+}
+
+void PigpioBackend::i2cWriteByte(unsigned handle, uint8_t reg, uint8_t data) {
+    pigpio::checkError(i2cWriteByteData(handle, reg, data));
+}
+
+uint8_t PigpioBackend::i2cReadByte(unsigned handle, uint8_t reg) {
+    return pigpio::checkError(i2cReadByteData(handle, reg));
+}
+
+void PigpioBackend::i2cWriteWord(unsigned handle, uint8_t reg, uint16_t data) {
+    pigpio::checkError(i2cWriteWordData(handle, reg, data));
+}
+
+uint16_t PigpioBackend::i2cReadWord(unsigned handle, uint8_t reg) {
+    return pigpio::checkError(i2cReadWordData(handle, reg));
+}
+
+void PigpioBackend::i2cWriteBlock(unsigned handle, uint8_t reg, std::span<const uint8_t> data) {
+    if (data.size() <= SMBUS_BLOCK_MAX) {
+        // pigpio takes a non-const buffer but only reads it.
+        auto* buffer = reinterpret_cast<char*>(const_cast<uint8_t*>(data.data()));
+        pigpio::checkError(i2cWriteI2CBlockData(handle, reg, buffer, data.size()));
+        return;
+    }
+
+    // Longer blocks are written to the device directly, with the register as the first byte.
+    constexpr size_t MAX_BLOCK = 64;
+    if (data.size() > MAX_BLOCK) {
+        throw std::invalid_argument(std::format("wiring::PigpioBackend::i2cWriteBlock(): Blocks are at most {} bytes", MAX_BLOCK));
+    }
+    std::array<char, MAX_BLOCK + 1> buffer;
+    buffer[0] = char(reg);
+    std::memcpy(buffer.data() + 1, data.data(), data.size());
+    pigpio::checkError(i2cWriteDevice(handle, buffer.data(), data.size() + 1));
+}
+
+void PigpioBackend::i2cReadBlock(unsigned handle, uint8_t reg, std::span<uint8_t> data) {
+    auto* buffer = reinterpret_cast<char*>(data.data());
+    int read;
+    if (data.size() <= SMBUS_BLOCK_MAX) {
+        read = pigpio::checkError(i2cReadI2CBlockData(handle, reg, buffer, data.size()));
+    }
+    else {
+        // SMBus block reads stop at 32 bytes, so longer reads select the register and then read the device directly.
+        pigpio::checkError(::i2cWriteByte(handle, reg));
+        read = pigpio::checkError(i2cReadDevice(handle, buffer, data.size()));
+    }
+    if (size_t(read) != data.size()) {
+        throw std::runtime_error(std::format("wiring::PigpioBackend::i2cReadBlock(): Read {} of {} bytes", read, data.size()));
+    }
+}
+
+} // namespace wiring
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+
+#include "Backend.hpp"
+
+namespace wiring {
+
+// Talks to the hardware through the pigpio library.
+// Outputs are written one at a time, as emergency stops and pings write them from other threads than the tick.
+class PigpioBackend : public Backend {
+public:
+    void initialise() override;
+    void terminate() override;
+
+    void setMode(int pin, PinMode mode) override;
+
+    using Backend::write;
+    using Backend::read;
+    void write(int pin, bool level) override;
+    bool read(int pin) override;
+
+    // At most one set and one clear per bank of 32 pins.
+    void write(uint64_t mask, uint64_t levels) override;
+
+    // One read per bank of 32 pins.
+    uint64_t read(uint64_t mask) override;
+
+    // Timed by pigpio without blocking, for pulses of up to 100 us.
+    void trigger(int pin, Clock::duration pulse, bool level = true) override;
+
+    // Alerts are called from the pigpio thread, which samples the pins every 5 us.
+    void setAlert(int pin, Alert alert) override;
+    void setGlitchFilter(int pin, Clock::duration steady) override;
+
+    void setPwmRange(int pin, int range) override;
+    int pwmRange(int pin) override;
+    void setPwmFrequency(int pin, int freq) override;
+    void pwm(int pin, int duty) override;
+
+    void servo(int pin, int pulseWidth) override;
+
+    unsigned i2cOpen(unsigned bus, uint8_t address) override;
+    void i2cClose(unsigned handle) override;
+
+    void i2cWriteByte(unsigned handle, uint8_t reg, uint8_t data) override;
+    uint8_t i2cReadByte(unsigned handle, uint8_t reg) override;
+
+    void i2cWriteWord(unsigned handle, uint8_t reg, uint16_t data) override;
+    uint16_t i2cReadWord(unsigned handle, uint8_t reg) override;
+
+    void i2cWriteBlock(unsigned handle, uint8_t reg, std::span<const uint8_t> data) override;
+    void i2cReadBlock(unsigned handle, uint8_t reg, std::span<uint8_t> data) override;
+
+private:
+    static constexpr int NUM_PINS = 54;
+
+    std::array<Alert, NUM_PINS> m_alerts = {};
+    std::mutex m_outputMutex;
+};
+
+} // namespace wiring
@@ -1,42 +1,57 @@
 #include <algorithm>
+#include <cmath>
 #include <format>
 #include <stdexcept>
 #include <string>
-#include <pigpio.h>
 
 #include "utils/Logger.hpp"
 #include "utils/Other.hpp"
-#include "utils/PigpioError.hpp"
 
 #include "Pin.hpp"
 
 namespace wiring {
 
-Pin::Pin(int pin) : m_pin(pinRemap(pin)), m_ctx(pin) {}
+Pin::Pin(int pin, bool onPi) : m_pin(onPi ? pinRemap(pin) : pin), m_bank(Bank::get()) {
+    if (onPi) {
+        m_ctx.emplace(pin);
+    }
+}
 
 OutputPin::OutputPin(const PinConfig& config) :
     Pin(config.pin),
     m_invert(config.invert)
 {
-    gpioSetMode(m_pin, PI_OUTPUT);
+    m_bank.setMode(m_pin, PinMode::OUT);
     set(0.0f);
 }
 
 void OutputPin::set(float val) {
     logger.trace() << "wiring::OutputPin::set(): Value: " << val;
     m_val = std::clamp(val, 0.0f, 1.0f);
-    const auto write = (m_val < 0.5f) != m_invert ? PI_LOW : PI_HIGH;
-    const auto res = gpioWrite(m_pin, write);
-    pigpio::checkError(res);
+    m_bank.write(m_pin, (m_val < 0.5f) == m_invert);
+}
+
+void OutputPin::halt() noexcept {
+    try {
+        Backend::get().write(m_pin, m_invert);
+    }
+    catch (const std::exception& e) {
+        logger.error() << "wiring::OutputPin::halt(): " << e.what();
+    }
+}
+
+void OutputPin::pulse(Clock::duration width) {
+    Backend::get().trigger(m_pin, width, !m_invert);
 }
 
 
 PwmPin::PwmPin(const PinConfig& config) :
     OutputPin(config.pin, config.invert)
 {
-    gpioSetMode(m_pin, PI_ALT5);
-    gpioSetPWMrange(m_pin, config.pwm.range);
-    gpioSetPWMfrequency(m_pin, config.pwm.freq);
+    m_bank.setMode(m_pin, PinMode::PWM);
+    m_bank.setPwmRange(m_pin, config.pwm.range);
+    m_range = m_bank.pwmRange(m_pin);
+    m_bank.setPwmFrequency(m_pin, config.pwm.freq);
     set(0.0f);
 }
 
@@ -45,17 +60,23 @@ void PwmPin::set(float val) {
     if (m_invert) val = 1.0f - val;
     m_val = val;
     
-    const auto range = gpioGetPWMrange(m_pin);
-    const auto write = int(val * range);
-    const auto res = gpioPWM(m_pin, write);
-    pigpio::checkError(res);
+    m_bank.pwm(m_pin, int(val * m_bank.pwmRange(m_pin)));
+}
+
+void PwmPin::halt() noexcept {
+    try {
+        Backend::get().pwm(m_pin, m_invert ? m_range : 0);
+    }
+    catch (const std::exception& e) {
+        logger.error() << "wiring::PwmPin::halt(): " << e.what();
+    }
 }
 
 
 ServoPin::ServoPin(const PinConfig& config) :
     OutputPin(config.pin, config.invert)
 {
-    gpioSetMode(m_pin, PI_ALT5);
+    m_bank.setMode(m_pin, PinMode::SERVO);
     set(0.0f);
 }
 
@@ -63,9 +84,69 @@ void ServoPin::set(float val) {
     if (m_invert) val *= -1.0f;
     m_val = val;
     
-    const int write = int(val * 1000.0f) + 1500;
-    const auto res = gpioServo(m_pin, write);
-    pigpio::checkError(res);
+    m_bank.servo(m_pin, int(val * 1000.0f) + 1500);
+}
+
+void ServoPin::halt() noexcept {
+    try {
+        Backend::get().servo(m_pin, 1500);
+    }
+    catch (const std::exception& e) {
+        logger.error() << "wiring::ServoPin::halt(): " << e.what();
+    }
+}
+
+
+ExpanderPin::ExpanderPin(const PinConfig& config) :
+    Pin(config.pin, false),
+    m_mode(config.mode),
+    m_invert(config.invert),
+    m_chip(Pca9685::get(config.expander))
+{
+    if (m_pin < 0 || m_pin >= Pca9685::NUM_CHANNELS) {
+        throw std::invalid_argument(std::format("wiring::ExpanderPin::ExpanderPin(): Channel is out of range 0-{}: {}", Pca9685::NUM_CHANNELS - 1, m_pin));
+    }
+    set(0.0f);
+}
+
+ExpanderPin::~ExpanderPin() {
+    set(0.0f);
+    m_chip->commit();
+}
+
+int ExpanderPin::ticks(float val) const {
+    switch (m_mode) {
+    case PinMode::OUT:
+        return (val < 0.5f) == m_invert ? Pca9685::RESOLUTION : 0;
+    case PinMode::PWM:
+        val = std::clamp(val, 0.0f, 1.0f);
+        if (m_invert) val = 1.0f - val;
+        return int(std::lround(val * Pca9685::RESOLUTION));
+    case PinMode::SERVO: {
+        if (m_invert) val *= -1.0f;
+        // The same pulse widths as a ServoPin, in ticks of the chip's period.
+        const auto pulseWidth = val * 1000.0f + 1500.0f;
+        return int(std::lround(pulseWidth * 1e-6f * m_chip->frequency() * Pca9685::RESOLUTION));
+    }
+    default: throw std::logic_error(std::format("wiring::ExpanderPin: Unexpected pin mode: {}", to_underlying(m_mode)));
+    }
+}
+
+void ExpanderPin::set(float val) {
+    m_val = m_mode == PinMode::SERVO ? val : std::clamp(val, 0.0f, 1.0f);
+    m_chip->stage(m_pin, ticks(val));
+    if (!m_bank.deferred()) {
+        m_chip->commit();
+    }
+}
+
+void ExpanderPin::halt() noexcept {
+    try {
+        m_chip->halt(m_pin, ticks(0.0f));
+    }
+    catch (const std::exception& e) {
+        logger.error() << "wiring::ExpanderPin::halt(): " << e.what();
+    }
 }
 
 
@@ -73,7 +154,26 @@ InputPin::InputPin(const PinConfig& config) :
     Pin(config.pin),
     m_invert(config.invert)
 {
-    gpioSetMode(m_pin, PI_INPUT);
+    m_bank.setMode(m_pin, PinMode::IN);
+}
+
+InputPin::~InputPin() {
+    if (m_alert) {
+        Backend::get().setAlert(m_pin, nullptr);
+    }
+}
+
+void InputPin::setAlert(Backend::Alert alert, Clock::duration glitch) {
+    auto& backend = Backend::get();
+    backend.setAlert(m_pin, nullptr);
+    m_alert = std::move(alert);
+    if (!m_alert) {
+        return;
+    }
+    backend.setGlitchFilter(m_pin, glitch);
+    backend.setAlert(m_pin, [this](int pin, bool level, Clock::time_point time) {
+        m_alert(pin, level != m_invert, time);
+    });
 }
 
 void InputPin::set(float val) {
@@ -81,15 +181,22 @@ void InputPin::set(float val) {
 }
 
 float InputPin::get() {
-    const auto read = gpioRead(m_pin);
-    pigpio::checkError(read);
-    auto val = float(read);
+    auto val = m_bank.read(m_pin) ? 1.0f : 0.0f;
     if (m_invert) val = 1.0f - val;
     return val;
 }
 
 
 std::unique_ptr<Pin> Pin::create(const PinConfig& config) {
+    if (config.expander != 0) {
+        switch (config.mode) {
+        case PinMode::OUT:
+        case PinMode::PWM:
+        case PinMode::SERVO: return std::make_unique<ExpanderPin>(config);
+        default: throw std::invalid_argument(std::format("wiring::Pin::create(): Expander pins can only be outputs, not mode {}", to_underlying(config.mode)));
+        }
+    }
+
     switch (config.mode) {
     case PinMode::OUT:   return std::make_unique<OutputPin>(config);
     case PinMode::PWM:   return std::make_unique<PwmPin>   (config);
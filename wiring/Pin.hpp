@@ -2,8 +2,11 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
 
+#include "Bank.hpp"
 #include "Context.hpp"
+#include "Pca9685.hpp"
 #include "PinConfig.hpp"
 
 namespace wiring {
@@ -17,23 +20,39 @@ public:
     virtual void set(float val) = 0;
     virtual float get() = 0;
 
+    // Sets the hardware to what set(0) would, straight through the backend instead of the Bank.
+    // Safe to call from any thread, for stopping things without waiting for the next commit.
+    // Failures are logged rather than thrown, as nothing on the alert and drain threads could handle them.
+    virtual void halt() noexcept {}
+
 protected:
-    Pin(int pin);
+    // Pins that are not on the Pi, like expander channels, are not remapped and claim no GPIO.
+    Pin(int pin, bool onPi = true);
 
     const int m_pin;
+    Bank& m_bank;
 
 private:
-    const Context m_ctx;
+    std::optional<Context> m_ctx;
 };
 
 class OutputPin : public Pin {
 public:
     OutputPin(const PinConfig& config);
-    virtual ~OutputPin() override { set(0.0f); }
+    virtual ~OutputPin() override {
+        set(0.0f);
+        m_bank.commit();
+    }
 
     virtual void set(float val) override;
     virtual float get() override { return m_val; }
 
+    virtual void halt() noexcept override;
+
+    // Pulses the pin on for width straight through the backend, for triggers that can not wait for the next commit.
+    // Safe to call from any thread.
+    void pulse(Clock::duration width);
+
 protected:
     OutputPin(int pin, bool invert) : Pin(pin), m_invert(invert) {}
 
@@ -47,6 +66,11 @@ public:
     virtual ~PwmPin() override { set(0.0f); }
 
     void set(float val) override;
+    void halt() noexcept override;
+
+private:
+    // Kept for halt(), so other threads never read the Bank.
+    int m_range = 0;
 };
 
 class ServoPin : public OutputPin {
@@ -58,19 +82,51 @@ public:
     //  0.0 -> 1500 us
     // -1.0 ->  500 us
     void set(float val) override;
+    void halt() noexcept override;
+};
+
+// A channel of a PCA9685. Digital pins are held fully on or off and servo pulses are timed at the chip's frequency.
+// Writes are committed with the Bank, along with every other channel of the chip.
+class ExpanderPin : public Pin {
+public:
+    ExpanderPin(const PinConfig& config);
+    virtual ~ExpanderPin() override;
+
+    // Takes the same values as the Pi's pin of the same mode.
+    void set(float val) override;
+    float get() override { return m_val; }
+
+    void halt() noexcept override;
+
+private:
+    // The ticks of each period the channel is on for the value.
+    int ticks(float val) const;
+
+    const PinMode m_mode;
+    const bool m_invert;
+    const std::shared_ptr<Pca9685> m_chip;
+    float m_val = 0.0f;
 };
 
 class InputPin : public Pin {
 public:
     InputPin(const PinConfig& config);
+    virtual ~InputPin() override;
 
     virtual void set(float val) override;
     virtual float get() override;
 
+    // Calls alert from a backend thread on every edge, with the level inverted if the pin is.
+    // Edges are only reported once the level has been steady for glitch.
+    void setAlert(Backend::Alert alert, Clock::duration glitch = {});
+
 protected:
     InputPin(int pin, bool invert) : Pin(pin), m_invert(invert) {}
 
     const bool m_invert;
+
+private:
+    Backend::Alert m_alert;
 };
 
 } // namespace wiring
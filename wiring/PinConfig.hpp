@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string_view>
 
 namespace wiring {
@@ -29,6 +30,9 @@ struct PinConfig {
     PinMode mode = PinMode::NONE;
     bool invert = false;
     PwmConfig pwm = {};
+    // The I2C address of the PCA9685 the pin is a channel of, or 0 for the Pi's own pins.
+    // Expander pins are outputs at the chip's frequency, so the PWM config does not apply.
+    uint8_t expander = 0;
 };
 
 } // namespace wiring
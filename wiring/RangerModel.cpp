@@ -0,0 +1,87 @@
+#include <cmath>
+#include <numbers>
+
+#include "RangerModel.hpp"
+
+namespace wiring {
+
+// The 8 cycle burst at 40 kHz goes out before the echo pin rises.
+constexpr auto BURST = std::chrono::microseconds(200);
+constexpr float WALL = 1.0f;
+constexpr float WALL_SPACING = 0.5f;
+constexpr float SWAY = 0.3f;
+constexpr float SWAY_FREQ = 0.2f;
+// One ping in this many comes back off something close by.
+constexpr size_t STRAY_EVERY = 16;
+constexpr float STRAY_DISTANCE = 0.1f;
+
+RangerModel::RangerModel(Echo echo, int index) :
+    m_echo(std::move(echo)),
+    m_index(index)
+{}
+
+RangerModel::~RangerModel() {
+    if (m_thread.joinable()) {
+        {
+            const std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+}
+
+float RangerModel::distance(Clock::time_point time) const {
+    const auto t = std::chrono::duration<float>(time.time_since_epoch()).count();
+    return WALL + WALL_SPACING * float(m_index) + SWAY * std::sin(2.0f * std::numbers::pi_v<float> * SWAY_FREQ * t);
+}
+
+size_t RangerModel::pings() const {
+    const std::lock_guard lock(m_mutex);
+    return m_pings;
+}
+
+void RangerModel::trigger() {
+    {
+        const std::lock_guard lock(m_mutex);
+        // The ranger ignores triggers while it is still listening.
+        if (m_rise != std::chrono::steady_clock::time_point::max()) {
+            return;
+        }
+        m_pings++;
+        const auto range = m_pings % STRAY_EVERY == 0 ? STRAY_DISTANCE : distance(Clock::now());
+        const auto roundTrip = std::chrono::duration<float>(2.0f * range / SPEED_OF_SOUND);
+        m_rise = std::chrono::steady_clock::now() + BURST;
+        m_fall = m_rise + std::chrono::duration_cast<std::chrono::steady_clock::duration>(roundTrip);
+
+        // The thread is only started by the first ping and then lives as long as the model.
+        if (!m_thread.joinable()) {
+            m_thread = std::thread(&RangerModel::run, this);
+        }
+    }
+    m_wake.notify_one();
+}
+
+void RangerModel::run() {
+    std::unique_lock lock(m_mutex);
+    while (!m_stop) {
+        if (m_rise == std::chrono::steady_clock::time_point::max()) {
+            m_wake.wait(lock);
+            continue;
+        }
+        const auto rise = m_rise;
+        const auto fall = m_fall;
+        m_wake.wait_until(lock, rise, [this] { return m_stop; });
+        if (m_stop) {
+            break;
+        }
+        lock.unlock();
+        m_echo(true);
+        std::this_thread::sleep_until(fall);
+        m_echo(false);
+        lock.lock();
+        m_rise = std::chrono::steady_clock::time_point::max();
+    }
+}
+
+} // namespace wiring
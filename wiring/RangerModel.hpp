@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "utils/Clock.hpp"
+#include "utils/Function.hpp"
+
+namespace wiring {
+
+// A simulated HC-SR04 ultrasonic ranger facing a wall that slowly moves back and forth.
+// Each trigger raises the echo pin after the burst has gone out and holds it for the round trip,
+// and every so often a ping comes back early off something else, so filters have an outlier to deal with.
+class RangerModel {
+public:
+    using Echo = Function<void(bool level)>;
+
+    static constexpr float SPEED_OF_SOUND = 343.0f;
+
+    // echo drives whatever the echo pin is wired to. Rangers with another index see the wall at another distance.
+    RangerModel(Echo echo, int index = 0);
+    ~RangerModel();
+
+    RangerModel(const RangerModel&) = delete;
+    RangerModel& operator=(const RangerModel&) = delete;
+
+    // Called at the falling edge of the trigger pulse.
+    void trigger();
+
+    // The distance to the wall in m at time.
+    float distance(Clock::time_point time) const;
+
+    size_t pings() const;
+
+private:
+    void run();
+
+    const Echo m_echo;
+    const int m_index;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    // When to raise and drop the echo pin, max while idle.
+    std::chrono::steady_clock::time_point m_rise = std::chrono::steady_clock::time_point::max();
+    std::chrono::steady_clock::time_point m_fall = std::chrono::steady_clock::time_point::max();
+    size_t m_pings = 0;
+    bool m_stop = false;
+    std::thread m_thread;
+};
+
+} // namespace wiring
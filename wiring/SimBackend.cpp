@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+#include "utils/Logger.hpp"
+
+#include "Ads1115Model.hpp"
+#include "Mpu6050Model.hpp"
+#include "Pca9685Model.hpp"
+#include "SimBackend.hpp"
+
+namespace wiring {
+
+SimBackend::SimBackend() {
+    for (auto& p : m_pins) {
+        p.samples.resize(WAVEFORM_SIZE);
+    }
+    attach(I2C_BUS, Mpu6050Model::ADDRESS, std::make_unique<Mpu6050Model>([this](bool level) { drive(GYRO_INT_PIN, level); }));
+    attachMux(I2C_BUS, MUX_ADDRESS);
+    // Behind the mux at the other address, as one wired straight to the bus would answer along with them.
+    for (int channel = 0; channel < 2; channel++) {
+        attach(I2C_BUS, MUX_ADDRESS, channel, Mpu6050Model::ALT_ADDRESS, std::make_unique<Mpu6050Model>());
+    }
+    attach(I2C_BUS, Pca9685Model::ADDRESS, std::make_unique<Pca9685Model>());
+    attach(I2C_BUS, Ads1115Model::ADDRESS, std::make_unique<Ads1115Model>([this](bool level) { drive(ADC_READY_PIN, level); }));
+    for (size_t i = 0; i < RANGER_PINS.size(); i++) {
+        const auto [trigger, echo] = RANGER_PINS[i];
+        m_rangers[trigger] = std::make_unique<RangerModel>([this, echo](bool level) { drive(echo, level); }, int(i));
+    }
+    m_encoder = std::make_unique<EncoderModel>([this](int channel, bool level) {
+        drive(channel == 0 ? ENCODER_PINS.first : ENCODER_PINS.second, level);
+    });
+}
+
+SimBackend::~SimBackend() {
+    // Stop the models first, as their threads may still be using the pins and the bus.
+    m_models.clear();
+    m_rangers.clear();
+    m_encoder.reset();
+}
+
+SimBackend::SimPin& SimBackend::pin(int pin) {
+    if (pin < 0 || pin >= NUM_PINS) {
+        throw std::invalid_argument(std::format("wiring::SimBackend: Pin is out of range 0-{}: {}", NUM_PINS - 1, pin));
+    }
+    return m_pins[pin];
+}
+
+const SimBackend::SimPin& SimBackend::pin(int pin) const {
+    return const_cast<SimBackend*>(this)->pin(pin);
+}
+
+void SimBackend::record(SimPin& pin, float value) {
+    if (pin.count > 0 && pin.value == value) {
+        return;
+    }
+    pin.value = value;
+    pin.samples[pin.next] = {Clock::now(), value};
+    pin.next = (pin.next + 1) % pin.samples.size();
+    pin.count = std::min(pin.count + 1, pin.samples.size());
+}
+
+void SimBackend::setMode(int p, PinMode mode) {
+    pin(p).mode = mode;
+}
+
+void SimBackend::write(int p, bool level) {
+    const std::lock_guard lock(m_pinMutex);
+    // Like pigpio, writing switches the pin to an output.
+    auto& simPin = pin(p);
+    simPin.mode = PinMode::OUT;
+    simPin.level = level;
+    record(simPin, level ? 1.0f : 0.0f);
+}
+
+void SimBackend::trigger(int p, Clock::duration, bool level) {
+    {
+        const std::lock_guard lock(m_pinMutex);
+        auto& simPin = pin(p);
+        simPin.mode = PinMode::OUT;
+        record(simPin, level ? 1.0f : 0.0f);
+        simPin.level = !level;
+        record(simPin, level ? 0.0f : 1.0f);
+    }
+    const auto it = m_rangers.find(p);
+    if (it != m_rangers.end()) {
+        it->second->trigger();
+    }
+}
+
+RangerModel& SimBackend::ranger(int p) const {
+    const auto it = m_rangers.find(p);
+    if (it == m_rangers.end()) {
+        throw std::invalid_argument(std::format("wiring::SimBackend::ranger(): No ranger triggered by pin {}", p));
+    }
+    return *it->second;
+}
+
+bool SimBackend::read(int p) {
+    const std::lock_guard lock(m_pinMutex);
+    return pin(p).level;
+}
+
+void SimBackend::setPwmRange(int p, int range) {
+    if (range < 25 || range > 40000) {
+        throw std::invalid_argument(std::format("wiring::SimBackend::setPwmRange(): Range not 25-40000: {}", range));
+    }
+    pin(p).range = range;
+}
+
+int SimBackend::pwmRange(int p) {
+    return pin(p).range;
+}
+
+void SimBackend::setPwmFrequency(int p, int freq) {
+    pin(p).freq = freq;
+}
+
+void SimBackend::pwm(int p, int duty) {
+    const std::lock_guard lock(m_pinMutex);
+    auto& simPin = pin(p);
+    if (duty < 0 || duty > simPin.range) {
+        throw std::invalid_argument(std::format("wiring::SimBackend::pwm(): Duty cycle outside range: {}", duty));
+    }
+    record(simPin, float(duty) / simPin.range);
+}
+
+void SimBackend::servo(int p, int pulseWidth) {
+    if (pulseWidth != 0 && (pulseWidth < 500 || pulseWidth > 2500)) {
+        throw std::invalid_argument(std::format("wiring::SimBackend::servo(): Pulse width not 0 or 500-2500: {}", pulseWidth));
+    }
+    const std::lock_guard lock(m_pinMutex);
+    record(pin(p), float(pulseWidth));
+}
+
+void SimBackend::setAlert(int p, Alert alert) {
+    const std::lock_guard lock(m_alertMutex);
+    pin(p).alert = std::move(alert);
+}
+
+void SimBackend::setGlitchFilter(int p, Clock::duration steady) {
+    if (steady < Clock::duration::zero() || steady > std::chrono::milliseconds(300)) {
+        throw std::invalid_argument("wiring::SimBackend::setGlitchFilter(): Filter not 0-300 ms");
+    }
+    pin(p);
+}
+
+void SimBackend::drive(int p, bool level) {
+    const std::lock_guard alertLock(m_alertMutex);
+    auto& simPin = pin(p);
+    bool changed;
+    {
+        const std::lock_guard lock(m_pinMutex);
+        changed = simPin.level != level;
+        simPin.level = level;
+        record(simPin, level ? 1.0f : 0.0f);
+    }
+    if (changed && simPin.alert) {
+        simPin.alert(p, level, Clock::now());
+    }
+}
+
+std::vector<SimBackend::Sample> SimBackend::waveform(int p) const {
+    const auto& simPin = pin(p);
+    std::vector<Sample> samples;
+    samples.reserve(simPin.count);
+    const auto size = simPin.samples.size();
+    for (size_t i = 0; i < simPin.count; i++) {
+        samples.push_back(simPin.samples[(simPin.next + size - simPin.count + i) % size]);
+    }
+    return samples;
+}
+
+void SimBackend::attach(unsigned bus, uint8_t address, std::unique_ptr<I2cModel>&& model) {
+    const std::lock_guard lock(m_mutex);
+    m_models[{bus, 0, NO_CHANNEL, address}] = std::move(model);
+}
+
+void SimBackend::attach(unsigned bus, uint8_t mux, int channel, uint8_t address, std::unique_ptr<I2cModel>&& model) {
+    const std::lock_guard lock(m_mutex);
+    m_models[{bus, mux, channel, address}] = std::move(model);
+}
+
+void SimBackend::attachMux(unsigned bus, uint8_t address) {
+    auto mux = std::make_unique<Tca9548aModel>();
+    const std::lock_guard lock(m_mutex);
+    m_muxes[{bus, address}] = mux.get();
+    m_models[{bus, 0, NO_CHANNEL, address}] = std::move(mux);
+}
+
+I2cModel& SimBackend::model(unsigned bus, uint8_t address) const {
+    const std::lock_guard lock(m_mutex);
+    const auto it = m_models.find({bus, 0, NO_CHANNEL, address});
+    if (it == m_models.end()) {
+        throw std::invalid_argument(std::format("wiring::SimBackend::model(): No device at {:#04x} on bus {}", address, bus));
+    }
+    return *it->second;
+}
+
+unsigned SimBackend::i2cOpen(unsigned bus, uint8_t address) {
+    const std::lock_guard lock(m_mutex);
+    // Like the real bus, opening does not talk to the device, but there should be one behind some channel.
+    const auto found = std::ranges::any_of(m_models, [bus, address](const auto& model) {
+        return std::get<0>(model.first) == bus && std::get<3>(model.first) == address;
+    });
+    if (!found) {
+        throw std::runtime_error(std::format("wiring::SimBackend::i2cOpen(): No device at {:#04x} on bus {}", address, bus));
+    }
+    logger.debug() << std::format("wiring::SimBackend::i2cOpen(): {:#04x} on bus {}", address, bus);
+    m_handles.emplace_back(std::pair(bus, address));
+    return m_handles.size() - 1;
+}
+
+void SimBackend::i2cClose(unsigned handle) {
+    const std::lock_guard lock(m_mutex);
+    if (handle >= m_handles.size() || !m_handles[handle]) {
+        throw std::invalid_argument(std::format("wiring::SimBackend: Bad I2C handle: {}", handle));
+    }
+    m_handles[handle].reset();
+}
+
+I2cModel* SimBackend::find(unsigned bus, uint8_t address) const {
+    // Every device at the address that can hear the bus answers, like on the real thing.
+    I2cModel* found = nullptr;
+    const auto answer = [&](I2cModel* model) {
+        if (found != nullptr) {
+            throw std::runtime_error(std::format("wiring::SimBackend: Several devices answered at {:#04x} on bus {}", address, bus));
+        }
+        found = model;
+    };
+    for (const auto& [location, mux] : m_muxes) {
+        if (location.first != bus) {
+            continue;
+        }
+        for (int channel = 0; channel < Tca9548aModel::CHANNELS; channel++) {
+            if ((mux->channels() & (1 << channel)) == 0) {
+                continue;
+            }
+            if (const auto it = m_models.find({bus, location.second, channel, address}); it != m_models.end()) {
+                answer(it->second.get());
+            }
+        }
+    }
+    if (const auto it = m_models.find({bus, 0, NO_CHANNEL, address}); it != m_models.end()) {
+        answer(it->second.get());
+    }
+    return found;
+}
+
+I2cModel& SimBackend::device(unsigned handle) const {
+    if (handle >= m_handles.size() || !m_handles[handle]) {
+        throw std::invalid_argument(std::format("wiring::SimBackend: Bad I2C handle: {}", handle));
+    }
+    const auto [bus, address] = *m_handles[handle];
+    auto* model = find(bus, address);
+    if (model == nullptr) {
+        throw std::runtime_error(std::format("wiring::SimBackend: Nothing answered at {:#04x} on bus {}", address, bus));
+    }
+    return *model;
+}
+
+void SimBackend::i2cWriteByte(unsigned handle, uint8_t reg, uint8_t data) {
+    const std::lock_guard lock(m_mutex);
+    device(handle).write(reg, data);
+}
+
+uint8_t SimBackend::i2cReadByte(unsigned handle, uint8_t reg) {
+    const std::lock_guard lock(m_mutex);
+    return device(handle).read(reg);
+}
+
+void SimBackend::i2cWriteWord(unsigned handle, uint8_t reg, uint16_t data) {
+    const std::lock_guard lock(m_mutex);
+    auto& model = device(handle);
+    model.write(reg, data & 0xFF);
+    model.write(model.next(reg), data >> 8);
+}
+
+uint16_t SimBackend::i2cReadWord(unsigned handle, uint8_t reg) {
+    const std::lock_guard lock(m_mutex);
+    auto& model = device(handle);
+    const uint16_t low = model.read(reg);
+    return low | (uint16_t(model.read(model.next(reg))) << 8);
+}
+
+void SimBackend::i2cWriteBlock(unsigned handle, uint8_t reg, std::span<const uint8_t> data) {
+    const std::lock_guard lock(m_mutex);
+    auto& model = device(handle);
+    for (const auto byte : data) {
+        model.write(reg, byte);
+        reg = model.next(reg);
+    }
+}
+
+void SimBackend::i2cReadBlock(unsigned handle, uint8_t reg, std::span<uint8_t> data) {
+    const std::lock_guard lock(m_mutex);
+    auto& model = device(handle);
+    for (auto& byte : data) {
+        byte = model.read(reg);
+        reg = model.next(reg);
+    }
+}
+
+} // namespace wiring
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "utils/Clock.hpp"
+
+#include "Backend.hpp"
+#include "EncoderModel.hpp"
+#include "RangerModel.hpp"
+
+namespace wiring {
+
+// A device on the simulated I2C bus.
+class I2cModel {
+public:
+    virtual ~I2cModel() {}
+
+    virtual uint8_t read(uint8_t reg) = 0;
+    virtual void write(uint8_t reg, uint8_t data) = 0;
+
+    // The register a burst moves on to after reg.
+    virtual uint8_t next(uint8_t reg) const { return reg + 1; }
+};
+
+// A device that is just a bank of 8 bit registers.
+class RegisterModel : public I2cModel {
+public:
+    uint8_t read(uint8_t reg) override { return m_registers[reg]; }
+    void write(uint8_t reg, uint8_t data) override { m_registers[reg] = data; }
+
+protected:
+    std::array<uint8_t, 256> m_registers = {};
+};
+
+// A TCA9548A I2C mux. Its only register is the mask of open channels and it keeps the last byte written.
+class Tca9548aModel : public I2cModel {
+public:
+    static constexpr int CHANNELS = 8;
+
+    uint8_t read(uint8_t) override { return m_channels; }
+    void write(uint8_t, uint8_t data) override { m_channels = data; }
+
+    uint8_t channels() const { return m_channels; }
+
+private:
+    uint8_t m_channels = 0;
+};
+
+// Runs everything in memory so the runtime works without a Pi.
+// Every change to an output pin is kept in a fixed size waveform per pin and I2C devices are register models.
+class SimBackend : public Backend {
+public:
+    static constexpr int NUM_PINS = 54;
+    static constexpr size_t WAVEFORM_SIZE = 1024;
+    static constexpr unsigned I2C_BUS = 1;
+    static constexpr uint8_t MUX_ADDRESS = 0x70;
+    static constexpr int NO_CHANNEL = -1;
+    // The MPU-6050's INT pin is wired to this BCM pin, which is pin 3 to the rest of the runtime.
+    static constexpr int GYRO_INT_PIN = 17;
+    // The ADS1115's ALERT/RDY pin is wired to this BCM pin, which is pin 4 to the rest of the runtime.
+    static constexpr int ADC_READY_PIN = 27;
+    // The trigger and echo BCM pins of the HC-SR04s, which are pins 5 and 6, and 10 and 11 to the rest of the runtime.
+    static constexpr std::array<std::pair<int, int>, 2> RANGER_PINS = {{{22, 10}, {5, 6}}};
+    // The A and B BCM pins of the quadrature encoder, which are pins 12 and 13 to the rest of the runtime.
+    static constexpr std::pair<int, int> ENCODER_PINS = {13, 19};
+
+    struct Sample {
+        Clock::time_point time;
+        // The level for digital pins, the duty cycle for PWM pins and the pulse width in us for servo pins.
+        float value;
+    };
+
+    // Starts with an MPU-6050 at 0x68 on the I2C bus, and at 0x69 on channels 0 and 1 of a TCA9548A at 0x70,
+    // a PCA9685 at 0x40 and an ADS1115 at 0x48, and with two HC-SR04 rangers and a quadrature encoder, which is stopped.
+    SimBackend();
+    ~SimBackend() override;
+
+    void initialise() override {}
+    void terminate() override {}
+
+    void setMode(int pin, PinMode mode) override;
+
+    using Backend::write;
+    using Backend::read;
+    void write(int pin, bool level) override;
+    bool read(int pin) override;
+
+    // Pings the ranger whose trigger is on the pin, if any.
+    void trigger(int pin, Clock::duration pulse, bool level = true) override;
+
+    // Alerts are called from drive().
+    void setAlert(int pin, Alert alert) override;
+
+    // Nothing glitches in the simulation, so this is only checked.
+    void setGlitchFilter(int pin, Clock::duration steady) override;
+
+    void setPwmRange(int pin, int range) override;
+    int pwmRange(int pin) override;
+    void setPwmFrequency(int pin, int freq) override;
+    void pwm(int pin, int duty) override;
+
+    void servo(int pin, int pulseWidth) override;
+
+    unsigned i2cOpen(unsigned bus, uint8_t address) override;
+    void i2cClose(unsigned handle) override;
+
+    void i2cWriteByte(unsigned handle, uint8_t reg, uint8_t data) override;
+    uint8_t i2cReadByte(unsigned handle, uint8_t reg) override;
+
+    void i2cWriteWord(unsigned handle, uint8_t reg, uint16_t data) override;
+    uint16_t i2cReadWord(unsigned handle, uint8_t reg) override;
+
+    void i2cWriteBlock(unsigned handle, uint8_t reg, std::span<const uint8_t> data) override;
+    void i2cReadBlock(unsigned handle, uint8_t reg, std::span<uint8_t> data) override;
+
+    // Puts a model on the bus, replacing whatever was at the address.
+    void attach(unsigned bus, uint8_t address, std::unique_ptr<I2cModel>&& model);
+    // Puts a model behind channel of the mux at mux.
+    void attach(unsigned bus, uint8_t mux, int channel, uint8_t address, std::unique_ptr<I2cModel>&& model);
+    // Puts a TCA9548A on the bus.
+    void attachMux(unsigned bus, uint8_t address);
+
+    // The model on the bus itself at the address.
+    I2cModel& model(unsigned bus, uint8_t address) const;
+
+    // Sets the level that an input pin reads and raises its alert on a change.
+    void drive(int pin, bool level);
+
+    // The ranger with its trigger on the pin.
+    RangerModel& ranger(int pin) const;
+
+    EncoderModel& encoder() const { return *m_encoder; }
+
+    // The most recent changes to the pin, oldest first.
+    std::vector<Sample> waveform(int pin) const;
+
+private:
+    struct SimPin {
+        PinMode mode = PinMode::NONE;
+        bool level = false;
+        int range = 255;
+        int freq = 1000;
+        float value = 0.0f;
+        Alert alert;
+        std::vector<Sample> samples;
+        size_t next = 0;
+        size_t count = 0;
+    };
+
+    SimPin& pin(int pin);
+    const SimPin& pin(int pin) const;
+    // The bus, mux, channel and address of a model. Models on the bus itself have no mux and no channel.
+    using Location = std::tuple<unsigned, uint8_t, int, uint8_t>;
+
+    // The model that answers to the handle's address through the channels that are open right now.
+    I2cModel& device(unsigned handle) const;
+    I2cModel* find(unsigned bus, uint8_t address) const;
+
+    // Adds a sample to the waveform if the value changed.
+    static void record(SimPin& pin, float value);
+
+    // Models may drive pins, and emergency stops write them, from their own threads.
+    // Alerts are called one at a time under m_alertMutex, like from pigpio's one thread, but with the pins unlocked
+    // so that they can write them.
+    std::mutex m_alertMutex;
+    mutable std::mutex m_pinMutex;
+    std::array<SimPin, NUM_PINS> m_pins;
+    std::map<Location, std::unique_ptr<I2cModel>> m_models;
+    std::map<std::pair<unsigned, uint8_t>, Tca9548aModel*> m_muxes;
+    // Indexed by trigger pin.
+    std::map<int, std::unique_ptr<RangerModel>> m_rangers;
+    std::unique_ptr<EncoderModel> m_encoder;
+    // The bus and address of each handle, indexed by handle and empty once closed.
+    std::vector<std::optional<std::pair<unsigned, uint8_t>>> m_handles;
+    // I2C devices may be read from other threads.
+    mutable std::mutex m_mutex;
+};
+
+} // namespace wiring